@@ -5,6 +5,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 using namespace engine;
 
@@ -29,44 +30,52 @@ int main() {
   registry.components.register_component<PositionComponent>();
   registry.components.register_component<VelocityComponent>();
   registry.components.register_component<NameComponent>();
-  ECS ecs;
+  const auto entities = registry.create_many(num_entities);
+  std::vector<Entity> positioned;
+  std::vector<Entity> moving;
   for (int i = 0; i < num_entities; i++) {
-    Entity e = ecs.create();
-    if (!registry.components.add_component<NameComponent>(
-            e, "Entity " + std::to_string(i))) {
+    if (i % 2 == 0)
+      positioned.push_back(entities[i]);
+    if (i % 3 == 0)
+      moving.push_back(entities[i]);
+  }
+  auto add_all = [](const char* name, std::size_t added, std::size_t count) {
+    if (added != count) {
       throw std::runtime_error(
-          fmt::format("Failed to add name component to {}", i));
-    }
-    if (i % 2 == 0) {
-      if (!registry.components.add_component<PositionComponent>(e, i, i))
-        throw std::runtime_error(
-            fmt::format("Failed to add position component to {}", i));
+          fmt::format("Failed to add {} {} components", count - added, name));
     }
-    if (i % 3 == 0) {
-      if (!registry.components.add_component<VelocityComponent>(e, i + 2,
-                                                                i + 1))
-        throw std::runtime_error(
-            fmt::format("Failed to add velocity component to {}", i));
-    }
-  }
-  // Accessors for the component data
-  auto get_position =
-      registry.components.component_accessor<PositionComponent>();
-  auto get_name = registry.components.component_accessor<NameComponent>();
-  auto get_velocity =
-      registry.components.component_accessor<VelocityComponent>();
-  // Entity groups/views by shared components
-  auto positioned_entities =
-      registry.components.has_component<NameComponent, PositionComponent>();
-  auto moving_entities =
-      registry.components
-          .has_component<NameComponent, PositionComponent, VelocityComponent>();
+  };
+  add_all("name",
+          registry.components.add_component_bulk<NameComponent>(
+              entities,
+              [](std::size_t i) {
+                return NameComponent{"Entity " + std::to_string(i)};
+              }),
+          entities.size());
+  add_all("position",
+          registry.components.add_component_bulk<PositionComponent>(
+              positioned,
+              [](std::size_t i) {
+                const int x = static_cast<int>(i) * 2;
+                return PositionComponent{x, x};
+              }),
+          positioned.size());
+  add_all("velocity",
+          registry.components.add_component_bulk<VelocityComponent>(
+              moving,
+              [](std::size_t i) {
+                const int x = static_cast<int>(i) * 3;
+                return VelocityComponent{x + 2, x + 1};
+              }),
+          moving.size());
   std::this_thread::sleep_for(std::chrono::seconds(10));
   fmt::print("# Entities:\n");
+  // Views are walked lazily, without collecting the matching entities
   int sum_x = 0;
   int sum_y = 0;
-  for (const auto& id : positioned_entities) {
-    PositionComponent& p = get_position(id);
+  for (auto [id, name, p] :
+       registry.components
+           .view<const NameComponent, const PositionComponent>()) {
     sum_x += p.x / 2;
     sum_y += p.y / 2;
   }
@@ -74,8 +83,9 @@ int main() {
 
   sum_x = 0;
   sum_y = 0;
-  for (const auto& id : moving_entities) {
-    VelocityComponent& v = get_velocity(id);
+  for (auto [id, name, p, v] :
+       registry.components.view<const NameComponent, const PositionComponent,
+                                const VelocityComponent>()) {
     sum_x += v.x;
     sum_y += v.y;
   }
@@ -1,4 +1,5 @@
 #include <engine/ecs.h>
+#include <engine/schedule.h>
 #include <fmt/core.h>
 #include <algorithm>
 #include <iostream>
@@ -41,6 +42,11 @@ struct AIComponent {
   std::mt19937 generator;
 };
 
+// Tile chosen by input_system, placed by play_move. -1 when there is none.
+struct MoveComponent {
+  int tile = -1;
+};
+
 std::vector<int> available_tiles(const BoardComponent& board) {
   std::vector<int> indices;
   for (int i = 0; i < board_size; i++) {
@@ -75,24 +81,35 @@ int ai_input(const std::vector<int>& open_indices, std::mt19937& generator) {
   return open_indices[dist(generator)];
 }
 
-void board_turn_system(BoardComponent& board) {
-  board.player_turn = !board.player_turn;
-}
-
-void input_system(BoardComponent& board, AIComponent& ai) {
+void input_system(const BoardComponent& board, const GameComponent& game,
+                  AIComponent& ai, MoveComponent& move) {
+  if (*game.game_over) {
+    return;
+  }
   auto tiles = available_tiles(board);
   if (tiles.empty()) {
     throw std::runtime_error("Invalid board state. No available moves.");
   }
   if (board.player_turn) {
-    int i = player_input(tiles);
-    board.state[i] = Tile::X;
+    move.tile = player_input(tiles);
   } else {
-    int i = ai_input(tiles, ai.generator);
-    board.state[i] = Tile::O;
+    move.tile = ai_input(tiles, ai.generator);
   }
 }
 
+// Places the chosen tile and passes the turn. The board is only accessed
+// mutably, and so marked as changed, when a move was made.
+void play_move(ComponentRegistry& components, Entity id) {
+  auto& move = components.get_component<MoveComponent>(id);
+  if (move.tile < 0) {
+    return;
+  }
+  auto& board = components.get_component<BoardComponent>(id);
+  board.state[move.tile] = board.player_turn ? Tile::X : Tile::O;
+  board.player_turn = !board.player_turn;
+  move.tile = -1;
+}
+
 constexpr std::array<std::array<int, 3>, 8> win_conditions = {{{0, 1, 2},
                                                                {3, 4, 5},
                                                                {6, 7, 8},
@@ -171,13 +188,13 @@ void render_system(const BoardComponent& board, const GameComponent& game) {
 void tictac() {
   bool game_over = false;
   Registry registry;
-  ECS ecs;
   registry.components.register_component<BoardComponent>();
   registry.components.register_component<AIComponent>();
   registry.components.register_component<GameComponent>();
+  registry.components.register_component<MoveComponent>();
   // Initialize board and game state
+  const Entity id = registry.create();
   {
-    Entity id = ecs.create();
     std::random_device dev;
     std::mt19937 generator{dev()};
     std::uniform_int_distribution<int> dist{0, 1};
@@ -188,6 +205,7 @@ void tictac() {
                                                       first_move);
     registry.components.add_component<AIComponent>(id, generator);
     registry.components.add_component<GameComponent>(id, &game_over);
+    registry.components.add_component<MoveComponent>(id);
 
     fmt::print(
         "tictac\n"
@@ -195,15 +213,17 @@ void tictac() {
         "You are X.\n");
   }
 
+  // Only rescan and redraw once a move changed the board, then ask for the
+  // next move
+  Schedule schedule;
+  schedule.add_system<Changed<BoardComponent>>(winner_system);
+  const auto render = schedule.add_system<Changed<BoardComponent>>(
+      render_system);
+  const auto input = schedule.add_system(input_system);
+  schedule.order(render, input);
   while (!game_over) {
-    foreach
-      <BoardComponent, AIComponent>(registry.components, input_system);
-    foreach
-      <BoardComponent>(registry.components, board_turn_system);
-    foreach
-      <BoardComponent, GameComponent>(registry.components, winner_system);
-    foreach
-      <BoardComponent, GameComponent>(registry.components, render_system);
+    schedule.run(registry.components);
+    play_move(registry.components, id);
   }
 }
 
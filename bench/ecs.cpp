@@ -0,0 +1,219 @@
+#include <benchmark/benchmark.h>
+#include <engine/ecs.h>
+#include <algorithm>
+#include <random>
+#include <ranges>
+#include <span>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+
+struct Enemy {};
+
+void register_components(Registry& registry) {
+  registry.components.register_component<PositionComponent>();
+  registry.components.register_component<VelocityComponent>();
+}
+
+// range(0) entities with a position and a velocity.
+std::vector<Entity> populate(Registry& registry, std::size_t count) {
+  register_components(registry);
+  auto entities = registry.create_many(count);
+  registry.components.add_component_bulk<PositionComponent>(
+      entities, [](std::size_t i) {
+        return PositionComponent{static_cast<int>(i), 0};
+      });
+  registry.components.add_component_bulk<VelocityComponent>(
+      entities, [](std::size_t) { return VelocityComponent{1, 1}; });
+  return entities;
+}
+
+// Destroys and recreates a tenth of range(0) entities with components.
+void BM_CreateDestroyChurn(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  auto entities = populate(registry, count);
+  const std::size_t batch = std::max<std::size_t>(count / 10, 1);
+  std::size_t next = 0;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch; i++) {
+      auto& id = entities[(next + i * 7) % count];
+      registry.destroy(id);
+      id = registry.create();
+      registry.components.add_component<PositionComponent>(id, 0, 0);
+    }
+    next++;
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_CreateDestroyChurn)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// Adds then removes a component on range(0) entities, one at a time.
+void BM_AddRemoveComponent(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  register_components(registry);
+  const auto entities = registry.create_many(count);
+  for (auto _ : state) {
+    for (const auto& id : entities) {
+      registry.components.add_component<PositionComponent>(id, 1, 1);
+    }
+    for (const auto& id : entities) {
+      registry.components.remove_component<PositionComponent>(id);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AddRemoveComponent)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// Same as BM_AddRemoveComponent with the bulk calls.
+void BM_AddRemoveComponentBulk(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  register_components(registry);
+  const auto entities = registry.create_many(count);
+  for (auto _ : state) {
+    registry.components.add_component_bulk<PositionComponent>(
+        entities, [](std::size_t) { return PositionComponent{1, 1}; });
+    registry.components.remove_bulk<PositionComponent>(entities);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AddRemoveComponentBulk)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000);
+
+void BM_HasComponent(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  populate(registry, count);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        registry.components.has_component<PositionComponent>());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_HasComponent)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// Every other entity has a velocity.
+void BM_HasComponentMulti(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  auto entities = populate(registry, count);
+  for (std::size_t i = 0; i < count; i += 2) {
+    registry.components.remove_component<VelocityComponent>(entities[i]);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        registry.components
+            .has_component<PositionComponent, VelocityComponent>());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_HasComponentMulti)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// The first 16 matches of BM_HasComponentMulti's query, through a view.
+void BM_ViewTake(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  auto entities = populate(registry, count);
+  for (std::size_t i = 0; i < count; i += 2) {
+    registry.components.remove_component<VelocityComponent>(entities[i]);
+  }
+  for (auto _ : state) {
+    for (auto entry : registry.components.view<const PositionComponent,
+                                               const VelocityComponent>() |
+                          std::views::take(16)) {
+      benchmark::DoNotOptimize(entry);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 16);
+}
+BENCHMARK(BM_ViewTake)->RangeMultiplier(10)->Range(1000, 1000000);
+
+void update_position(PositionComponent& p, const VelocityComponent& v) {
+  p.x += v.x;
+  p.y += v.y;
+}
+
+void BM_Foreach(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  populate(registry, count);
+  for (auto _ : state) {
+    foreach
+      <PositionComponent, VelocityComponent>(registry.components,
+                                             update_position);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Foreach)->RangeMultiplier(10)->Range(1000, 10000000);
+
+// Foreach after removing half of the velocities at random and adding them
+// back in a shuffled order, so the two pools no longer share an order.
+void BM_ForeachFragmented(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  auto entities = populate(registry, count);
+  std::mt19937 random{42};
+  std::shuffle(entities.begin(), entities.end(), random);
+  const std::span<const Entity> removed{entities.data(), count / 2};
+  registry.components.remove_bulk<VelocityComponent>(removed);
+  registry.components.add_component_bulk<VelocityComponent>(
+      removed, [](std::size_t) { return VelocityComponent{1, 1}; });
+  for (auto _ : state) {
+    foreach
+      <PositionComponent, VelocityComponent>(registry.components,
+                                             update_position);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ForeachFragmented)->RangeMultiplier(10)->Range(1000, 10000000);
+
+// Foreach over an owning group, which keeps the pools co-sorted.
+void BM_ForeachGroup(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  populate(registry, count);
+  auto& group =
+      registry.components.group<PositionComponent, VelocityComponent>();
+  for (auto _ : state) {
+    group.each(update_position);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ForeachGroup)->RangeMultiplier(10)->Range(1000, 10000000);
+
+// Foreach over positions filtered by a tag every other entity has.
+void BM_ForeachTagged(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  Registry registry;
+  const auto entities = populate(registry, count);
+  registry.components.register_component<Enemy>();
+  for (std::size_t i = 0; i < count; i += 2) {
+    registry.components.add_component<Enemy>(entities[i]);
+  }
+  for (auto _ : state) {
+    foreach
+      <PositionComponent, Enemy>(registry.components,
+                                 [](PositionComponent& p, Enemy) { p.x++; });
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count / 2);
+}
+BENCHMARK(BM_ForeachTagged)->RangeMultiplier(10)->Range(1000, 10000000);
+}  // namespace
@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+#include <engine/generational_index.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+// Frees and reallocates a tenth of range(0) live indices per iteration.
+void BM_AllocatorChurn(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  GenerationalIndexAllocator allocator;
+  auto live = allocator.allocate(count);
+  const std::size_t batch = std::max<std::size_t>(count / 10, 1);
+  std::size_t next = 0;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch; i++) {
+      auto& index = live[(next + i * 7) % count];
+      allocator.deallocate(index);
+      index = allocator.allocate();
+    }
+    next++;
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_AllocatorChurn)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// Emplaces then removes range(0) values.
+void BM_ArrayEmplaceRemove(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  GenerationalIndexAllocator allocator;
+  const auto indices = allocator.allocate(count);
+  GenerationalIndexArray<int> array;
+  for (auto _ : state) {
+    for (const auto& index : indices) {
+      array.emplace(index, 1);
+    }
+    for (const auto& index : indices) {
+      array.remove(index);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ArrayEmplaceRemove)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// Looks up range(0) values through the sparse array.
+void BM_ArrayGet(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  GenerationalIndexAllocator allocator;
+  const auto indices = allocator.allocate(count);
+  GenerationalIndexArray<int> array;
+  for (const auto& index : indices) {
+    array.emplace(index, 1);
+  }
+  const auto& values = std::as_const(array);
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& index : indices) {
+      sum += values.get(index);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ArrayGet)->RangeMultiplier(10)->Range(1000, 1000000);
+}  // namespace
@@ -0,0 +1,275 @@
+#ifndef ENGINE_ARCHETYPE_H
+#define ENGINE_ARCHETYPE_H
+
+#include <engine/ecs.h>
+#include <engine/generational_index.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// Type erased construction and destruction of a component type.
+struct ComponentInfo {
+  std::type_index type{typeid(void)};
+  std::size_t size = 0;
+  std::size_t alignment = 0;
+  // Move constructs dst from src, then destroys src.
+  void (*relocate)(void* dst, void* src) = nullptr;
+  void (*destroy)(void* ptr) = nullptr;
+
+  template <class T>
+  static ComponentInfo of() {
+    return {typeid(T), sizeof(T), alignof(T),
+            [](void* dst, void* src) {
+              std::construct_at(static_cast<T*>(dst),
+                                std::move(*static_cast<T*>(src)));
+              std::destroy_at(static_cast<T*>(src));
+            },
+            [](void* ptr) { std::destroy_at(static_cast<T*>(ptr)); }};
+  }
+};
+
+constexpr std::size_t archetype_chunk_size{16 * 1024};
+
+// Position of an entity's row inside an archetype.
+struct ArchetypeSlot {
+  std::size_t chunk = 0;
+  std::size_t row = 0;
+};
+
+// All entities sharing one component signature. Rows live in fixed size
+// chunks holding an entity column followed by one column per component.
+class Archetype {
+ public:
+  static constexpr std::size_t npos{std::numeric_limits<std::size_t>::max()};
+
+  // components must be sorted by type.
+  explicit Archetype(std::vector<ComponentInfo> components);
+  ~Archetype();
+
+  Archetype(const Archetype&) = delete;
+  Archetype& operator=(const Archetype&) = delete;
+
+  inline const std::vector<ComponentInfo>& components() const {
+    return _components;
+  }
+
+  // Column of type, or npos.
+  std::size_t column(std::type_index type) const;
+
+  inline bool has(std::type_index type) const { return column(type) != npos; }
+
+  // Appends a row for id. Its component slots are left uninitialized.
+  ArchetypeSlot allocate(const Entity& id);
+
+  // Frees slot, whose components must already be destroyed or relocated,
+  // by relocating the last row into it. Returns the entity that moved.
+  std::optional<Entity> release(const ArchetypeSlot& slot);
+
+  // Destroys slot's components, then releases it.
+  std::optional<Entity> erase(const ArchetypeSlot& slot);
+
+  inline void* get(std::size_t column, const ArchetypeSlot& slot) {
+    return _chunks[slot.chunk].data + _offsets[column] +
+           slot.row * _components[column].size;
+  }
+
+  inline Entity& entity(const ArchetypeSlot& slot) {
+    return reinterpret_cast<Entity*>(_chunks[slot.chunk].data)[slot.row];
+  }
+
+  template <class T>
+  inline T* column_data(std::size_t column, std::size_t chunk) {
+    return reinterpret_cast<T*>(_chunks[chunk].data + _offsets[column]);
+  }
+
+  inline std::size_t chunks() const { return _chunks.size(); }
+
+  inline std::size_t chunk_size(std::size_t chunk) const {
+    return _chunks[chunk].size;
+  }
+
+  inline std::size_t chunk_capacity() const { return _capacity; }
+
+  inline std::size_t size() const { return _size; }
+
+  // Cached transitions to the archetype with one component added/removed.
+  std::unordered_map<std::type_index, Archetype*> add_edges;
+  std::unordered_map<std::type_index, Archetype*> remove_edges;
+
+ private:
+  struct Chunk {
+    std::byte* data = nullptr;
+    std::size_t size = 0;
+  };
+
+  std::vector<ComponentInfo> _components;
+  // Byte offset of each component column, the entity column is at 0.
+  std::vector<std::size_t> _offsets;
+  std::size_t _capacity = 0;
+  std::size_t _bytes = 0;
+  std::size_t _size = 0;
+  std::vector<Chunk> _chunks;
+};
+
+// Component storage grouping entities by component signature into
+// Archetypes. Multi-component iteration streams through matching chunks
+// instead of probing one sparse array per component. Drop-in alternative to
+// ComponentRegistry, e.g. BasicRegistry<ArchetypeRegistry>.
+class ArchetypeRegistry {
+ public:
+  ArchetypeRegistry() = default;
+
+  template <class ComponentType>
+  bool register_component() {
+    return _infos
+        .try_emplace(typeid(ComponentType), ComponentInfo::of<ComponentType>())
+        .second;
+  }
+
+  template <class ComponentType, typename... Args>
+  bool add_component(Entity id, Args&&... args) {
+    const auto& info = registered_info(typeid(ComponentType));
+    Archetype* source = nullptr;
+    if (_locations.contains(id)) {
+      source = _locations.get(id).archetype;
+      if (source->has(info.type))
+        return false;
+    }
+    Archetype* target = with_component(source, info);
+    auto slot = target->allocate(id);
+    try {
+      std::construct_at(static_cast<ComponentType*>(target->get(
+                            target->column(info.type), slot)),
+                        std::forward<Args>(args)...);
+    } catch (...) {
+      target->release(slot);
+      throw;
+    }
+    move_entity(id, target, slot);
+    return true;
+  }
+
+  template <class ComponentType>
+  bool remove_component(Entity id) {
+    const auto& info = registered_info(typeid(ComponentType));
+    if (!_locations.contains(id))
+      return false;
+    auto& location = _locations.get(id);
+    auto* source = location.archetype;
+    auto column = source->column(info.type);
+    if (column == Archetype::npos)
+      return false;
+    info.destroy(source->get(column, location.slot));
+    Archetype* target = without_component(source, info);
+    if (target == nullptr) {
+      release(source, location.slot);
+      _locations.remove(id);
+      return true;
+    }
+    move_entity(id, target, target->allocate(id));
+    return true;
+  }
+
+  // Removes every component of id.
+  bool remove_all(Entity id);
+
+  template <class... ComponentType>
+  std::vector<Entity> has_component() {
+    std::vector<Entity> entities;
+    for_matching<ComponentType...>(
+        [&](Archetype& archetype, std::size_t chunk, auto*...) {
+          for (std::size_t row = 0; row < archetype.chunk_size(chunk); row++) {
+            entities.push_back(archetype.entity({chunk, row}));
+          }
+        });
+    return entities;
+  }
+
+  template <class ComponentType>
+  ComponentType& get_component(Entity id) {
+    auto& location = _locations.get(id);
+    auto column = location.archetype->column(typeid(ComponentType));
+    if (column == Archetype::npos) {
+      throw std::out_of_range("Entity does not have the component type.");
+    }
+    return *static_cast<ComponentType*>(
+        location.archetype->get(column, location.slot));
+  }
+
+  template <class ComponentType>
+  auto component_accessor() {
+    return [this](Entity id) -> ComponentType& {
+      return get_component<ComponentType>(id);
+    };
+  }
+
+  template <class... ComponentType, typename Func>
+  void each(Func f) {
+    for_matching<ComponentType...>(
+        [&](Archetype& archetype, std::size_t chunk, auto*... columns) {
+          const std::size_t size = archetype.chunk_size(chunk);
+          for (std::size_t row = 0; row < size; row++) {
+            f(columns[row]...);
+          }
+        });
+  }
+
+  inline std::size_t archetypes() const { return _archetypes.size(); }
+
+ private:
+  struct Location {
+    Archetype* archetype = nullptr;
+    ArchetypeSlot slot;
+  };
+
+  // Calls f(archetype, chunk, columns...) for every chunk of every
+  // archetype holding all of ComponentType, with typed column pointers.
+  template <class... ComponentType, typename Func>
+  void for_matching(Func f) {
+    for (auto& archetype : _archetypes) {
+      if (archetype->size() == 0)
+        continue;
+      const std::array<std::size_t, sizeof...(ComponentType)> columns{
+          archetype->column(typeid(ComponentType))...};
+      if (std::find(columns.begin(), columns.end(), Archetype::npos) !=
+          columns.end())
+        continue;
+      for (std::size_t chunk = 0; chunk < archetype->chunks(); chunk++) {
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+          f(*archetype, chunk,
+            archetype->template column_data<ComponentType>(columns[I],
+                                                           chunk)...);
+        }(std::index_sequence_for<ComponentType...>{});
+      }
+    }
+  }
+
+  const ComponentInfo& registered_info(std::type_index type) const;
+  Archetype* with_component(Archetype* source, const ComponentInfo& info);
+  Archetype* without_component(Archetype* source, const ComponentInfo& info);
+  Archetype* find_or_create(std::vector<ComponentInfo> components);
+  // Relocates id's remaining components into target's slot, whose other
+  // columns are already constructed, and releases the old row.
+  void move_entity(const Entity& id, Archetype* target,
+                   const ArchetypeSlot& slot);
+  void release(Archetype* archetype, const ArchetypeSlot& slot);
+
+  std::unordered_map<std::type_index, ComponentInfo> _infos;
+  std::vector<std::unique_ptr<Archetype>> _archetypes;
+  std::map<std::vector<std::type_index>, Archetype*> _signatures;
+  GenerationalIndexArray<Location> _locations;
+};
+};  // namespace engine
+#endif
@@ -0,0 +1,167 @@
+#ifndef ENGINE_COMMAND_BUFFER_H
+#define ENGINE_COMMAND_BUFFER_H
+
+#include <engine/ecs.h>
+#include <engine/thread_pool.h>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// Entity created by a CommandBuffer, only allocated when the buffer flushes.
+struct PendingEntity {
+  std::size_t index = 0;
+};
+
+// Structural change recorded for one component type.
+class CommandListBase {
+ public:
+  virtual ~CommandListBase() = default;
+
+  // Applies the changes in recorded order. created resolves PendingEntity.
+  virtual void apply(ComponentRegistry& components,
+                     std::span<const Entity> created) = 0;
+  virtual void clear() = 0;
+};
+
+template <class ComponentType>
+class CommandList : public CommandListBase {
+ public:
+  static constexpr std::size_t no_pending = static_cast<std::size_t>(-1);
+
+  // Adds value, or removes the component when value is empty, on id or on
+  // the pending entity when pending is set.
+  struct Command {
+    Entity id;
+    std::size_t pending = no_pending;
+    std::optional<ComponentType> value;
+  };
+
+  // Replays each run of consecutive adds or removes with one bulk call, so
+  // the pool reserves capacity once per run.
+  void apply(ComponentRegistry& components,
+             std::span<const Entity> created) override {
+    std::vector<Entity> ids;
+    std::size_t begin = 0;
+    while (begin < commands.size()) {
+      const bool adds = commands[begin].value.has_value();
+      std::size_t end = begin;
+      ids.clear();
+      for (; end < commands.size() && commands[end].value.has_value() == adds;
+           end++) {
+        const auto& command = commands[end];
+        ids.push_back(command.pending == no_pending ? command.id
+                                                    : created[command.pending]);
+      }
+      if (adds) {
+        components.add_component_bulk<ComponentType>(ids, [&](std::size_t i) {
+          return std::move(*commands[begin + i].value);
+        });
+      } else {
+        components.remove_bulk<ComponentType>(ids);
+      }
+      begin = end;
+    }
+  }
+
+  void clear() override { commands.clear(); }
+
+  std::vector<Command> commands;
+};
+
+// Records entity and component changes while systems iterate, so pools are
+// not restructured under a running foreach. flush applies everything at a
+// sync point, one component type at a time. Not thread safe, use one
+// buffer per thread through CommandBuffers.
+class CommandBuffer {
+ public:
+  CommandBuffer() = default;
+
+  inline PendingEntity create() { return {_created++}; }
+
+  inline void destroy(Entity id) {
+    _commands++;
+    _destroyed.push_back(id);
+  }
+
+  template <class ComponentType, typename... Args>
+  void add_component(Entity id, Args&&... args) {
+    list<ComponentType>().commands.push_back(
+        {id, CommandList<ComponentType>::no_pending,
+         std::optional<ComponentType>{std::in_place,
+                                      std::forward<Args>(args)...}});
+  }
+
+  template <class ComponentType, typename... Args>
+  void add_component(PendingEntity id, Args&&... args) {
+    list<ComponentType>().commands.push_back(
+        {Entity{}, id.index,
+         std::optional<ComponentType>{std::in_place,
+                                      std::forward<Args>(args)...}});
+  }
+
+  template <class ComponentType>
+  void remove_component(Entity id) {
+    list<ComponentType>().commands.push_back(
+        {id, CommandList<ComponentType>::no_pending, std::nullopt});
+  }
+
+  inline bool empty() const { return _commands == 0 && _created == 0; }
+
+  // Materializes entities reserved through ECS::reserve, creates the pending
+  // entities, applies component changes, then destroys entities along with
+  // their components. Changes to one component type replay in recorded
+  // order, so an add followed by a remove leaves no component. Returns the
+  // created entities in create() order.
+  std::vector<Entity> flush(ECS& ecs, ComponentRegistry& components);
+
+  void clear();
+
+ private:
+  friend class CommandBuffers;
+
+  template <class ComponentType>
+  CommandList<ComponentType>& list() {
+    _commands++;
+    auto it = _lists.find<ComponentType>();
+    if (it == _lists.end()) {
+      _lists.put<ComponentType>(std::make_unique<CommandList<ComponentType>>());
+      it = _lists.find<ComponentType>();
+    }
+    return static_cast<CommandList<ComponentType>&>(*it->second);
+  }
+
+  std::size_t _created = 0;
+  std::size_t _commands = 0;
+  std::vector<Entity> _destroyed;
+  TypeMap<std::unique_ptr<CommandListBase>> _lists;
+};
+
+// One CommandBuffer per thread of a ThreadPool plus one for other threads.
+// Threads that are not the pool's workers share that last buffer, so only
+// one of them may record at a time.
+class CommandBuffers {
+ public:
+  explicit CommandBuffers(ThreadPool& pool = default_thread_pool())
+      : _pool(pool), _buffers(pool.size() + 1) {}
+
+  inline CommandBuffer& local() { return _buffers[_pool.worker_index()]; }
+
+  inline std::size_t size() const { return _buffers.size(); }
+
+  inline CommandBuffer& operator[](std::size_t i) { return _buffers[i]; }
+
+  // Flushes every buffer in index order, but touches each component pool
+  // once for all buffers. Returns the created entities, buffer by buffer.
+  std::vector<Entity> flush(ECS& ecs, ComponentRegistry& components);
+
+ private:
+  ThreadPool& _pool;
+  std::vector<CommandBuffer> _buffers;
+};
+};  // namespace engine
+#endif
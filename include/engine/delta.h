@@ -0,0 +1,223 @@
+#ifndef ENGINE_DELTA_H
+#define ENGINE_DELTA_H
+
+#include <engine/ecs.h>
+#include <engine/generational_index.h>
+#include <engine/snapshot.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+
+constexpr std::uint32_t delta_version{2};
+
+// A delta is a DeltaHeader followed by
+//   the entity allocator slots whose version changed, in the order they
+//   last changed,
+//   the removed ids of every component type,
+//   the added or changed components of every component type, with ticks.
+// Removals come first so an entity's old generation is gone before its new
+// one gets components.
+struct DeltaHeader {
+  char magic[8];
+  std::uint32_t version;
+  // Number of component types in the delta.
+  std::uint32_t components;
+  // Changes after since, up to and including tick, are in the delta.
+  Tick since;
+  Tick tick;
+};
+
+namespace detail {
+void write_delta_header(SnapshotOutput& out, Tick since, Tick tick,
+                        std::size_t components);
+// Throws unless the header is valid and has components types.
+DeltaHeader read_delta_header(SnapshotInput& in, std::size_t components);
+void apply_entities(SnapshotInput& in, GenerationalIndexAllocator& allocator);
+
+template <class T>
+void write_value(SnapshotOutput& out, const T& value) {
+  if constexpr (snapshot_raw<T>) {
+    out.write(value);
+  } else {
+    static_assert(snapshot_serializable<T>,
+                  "Component needs snapshot_traits to be encoded.");
+    snapshot_traits<T>::save(out, value);
+  }
+}
+
+template <class T>
+T read_value(SnapshotInput& in) {
+  if constexpr (snapshot_raw<T>) {
+    return in.read<T>();
+  } else {
+    return snapshot_traits<T>::load(in);
+  }
+}
+
+inline void read_key(SnapshotInput& in, std::uint64_t key) {
+  if (in.read<std::uint64_t>() != key) {
+    throw std::runtime_error("Delta has different component types.");
+  }
+}
+
+template <class ComponentType>
+void encode_removals(SnapshotOutput& out,
+                     const GenerationalIndexArray<ComponentType>& pool,
+                     Tick since) {
+  // removals are logged in tick order
+  const auto& removals = pool.removals();
+  const auto first = std::partition_point(
+      removals.begin(), removals.end(),
+      [&](const LoggedIndex& removed) { return removed.tick <= since; });
+  out.write(snapshot_key<ComponentType>());
+  out.write<std::uint64_t>(removals.end() - first);
+  for (auto it = first; it != removals.end(); it++) {
+    out.write(it->index);
+  }
+}
+
+// Packed positions of the values changed after since, in order. The first
+// delta, since 0, takes every value, later ones only the logged changes.
+template <class ComponentType>
+std::vector<SparseArrayIndexType> changed_positions(
+    const GenerationalIndexArray<ComponentType>& pool, Tick since) {
+  const auto& ticks = pool.ticks();
+  std::vector<SparseArrayIndexType> positions;
+  if (since == 0) {
+    for (std::size_t i = 0; i < ticks.size(); i++) {
+      if (ticks[i].changed > since)
+        positions.push_back(static_cast<SparseArrayIndexType>(i));
+    }
+    return positions;
+  }
+  // changes are logged in tick order
+  const auto& changes = pool.changes();
+  const auto first = std::partition_point(
+      changes.begin(), changes.end(),
+      [&](const LoggedIndex& changed) { return changed.tick <= since; });
+  for (auto it = first; it != changes.end(); it++) {
+    // skips values removed since
+    const auto position = pool.position(it->index);
+    if (position != PagedSparseArray::tombstone &&
+        ticks[position].changed > since)
+      positions.push_back(position);
+  }
+  // a value changed in several ticks is logged once per tick
+  std::sort(positions.begin(), positions.end());
+  positions.erase(std::unique(positions.begin(), positions.end()),
+                  positions.end());
+  return positions;
+}
+
+template <class ComponentType>
+void encode_changes(SnapshotOutput& out,
+                    const GenerationalIndexArray<ComponentType>& pool,
+                    Tick since) {
+  const auto positions = changed_positions(pool, since);
+  out.write(snapshot_key<ComponentType>());
+  out.write<std::uint64_t>(positions.size());
+  for (const auto position : positions) {
+    out.write(pool.indices()[position]);
+    out.write(pool.ticks()[position]);
+    write_value(out, pool.values()[position]);
+  }
+}
+
+template <class ComponentType>
+void apply_removals(SnapshotInput& in, ComponentRegistry& components) {
+  read_key(in, snapshot_key<ComponentType>());
+  const auto count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; i++) {
+    components.remove_component<ComponentType>(in.read<Entity>());
+  }
+}
+
+template <class ComponentType>
+void apply_changes(SnapshotInput& in, ComponentRegistry& components) {
+  read_key(in, snapshot_key<ComponentType>());
+  auto& pool = components.pool<ComponentType>();
+  const auto count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; i++) {
+    const auto id = in.read<Entity>();
+    const auto ticks = in.read<ComponentTicks>();
+    auto value = read_value<ComponentType>(in);
+    if (auto* found = pool.find(id)) {
+      *found = std::move(value);
+    } else if (!components.add_component<ComponentType>(id,
+                                                         std::move(value))) {
+      throw std::runtime_error("Delta adds a component to an entity in use.");
+    }
+    pool.set_ticks_at(pool.position_unchecked(id), ticks);
+  }
+}
+};  // namespace detail
+
+// Encodes what changed in a registry since the previous encode, for
+// apply_delta to replay on a mirror. The first delta holds the whole state.
+// Turns on change logging for the registry's entities and components, so
+// later deltas cost time in the number of changes, not of entities.
+class DeltaEncoder {
+ public:
+  explicit DeltaEncoder(Registry& registry);
+
+  // The entities created or destroyed and the ...ComponentType added,
+  // changed or removed since the previous encode. Starts a new tick, so
+  // later changes go into the next delta, and trims the change logs.
+  template <class... ComponentType>
+  std::vector<std::byte> encode() {
+    static_assert(!(tag_component<ComponentType> || ...),
+                  "Tags have no ticks to encode changes with.");
+    auto& components = _registry.components;
+    (components.register_component<ComponentType>(), ...);
+    _registry.entities.flush();
+    const Tick tick = components.tick();
+    SnapshotOutput out;
+    detail::write_delta_header(out, _since, tick, sizeof...(ComponentType));
+    encode_entities(out);
+    (detail::encode_removals(out, components.pool<ComponentType>(), _since),
+     ...);
+    (detail::encode_changes(out, components.pool<ComponentType>(), _since),
+     ...);
+    components.trim_changes(tick);
+    components.advance_tick();
+    _since = tick;
+    return std::move(out.bytes());
+  }
+
+  // Tick of the previous encode, 0 before the first.
+  inline Tick since() const { return _since; }
+
+ private:
+  void encode_entities(SnapshotOutput& out);
+
+  Registry& _registry;
+  Tick _since = 0;
+};
+
+// Replays a delta of ...ComponentType, the types it was encoded with, on
+// registry. Deltas must be applied in order, starting with the first, and
+// registry must not be changed otherwise. Only the changed entity slots are
+// patched, so applying takes time linear in the size of the delta.
+template <class... ComponentType>
+void apply_delta(std::span<const std::byte> delta, Registry& registry) {
+  static_assert(!(tag_component<ComponentType> || ...),
+                "Tags have no ticks to encode changes with.");
+  SnapshotInput in{delta};
+  const auto header = detail::read_delta_header(in, sizeof...(ComponentType));
+  auto& components = registry.components;
+  if (header.since != 0 && header.since != components.tick()) {
+    throw std::runtime_error("Delta does not continue the registry's tick.");
+  }
+  (components.register_component<ComponentType>(), ...);
+  detail::apply_entities(in, registry.entities.allocator());
+  (detail::apply_removals<ComponentType>(in, components), ...);
+  (detail::apply_changes<ComponentType>(in, components), ...);
+  components.set_tick(header.tick);
+}
+};  // namespace engine
+#endif
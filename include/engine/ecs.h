@@ -1,41 +1,338 @@
 #ifndef ENGINE_ECS_H
 #define ENGINE_ECS_H
+#include <engine/filter.h>
+#include <engine/frame_arena.h>
 #include <engine/generational_index.h>
+#include <engine/group.h>
+#include <engine/profile.h>
+#include <engine/query.h>
+#include <engine/soa.h>
+#include <engine/system_traits.h>
+#include <engine/tag.h>
+#include <engine/thread_pool.h>
 #include <engine/type_map.h>
+#include <engine/view.h>
 #include <algorithm>
 #include <any>
+#include <array>
+#include <bitset>
+#include <concepts>
 #include <functional>
 #include <future>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace engine {
 
 using Entity = GenerationalIndex;
+namespace detail {
 template <typename T>
-using EntityMap = GenerationalIndexArray<T>;
+struct entity_map {
+  using type = GenerationalIndexArray<T>;
+};
+
+// soa_layout components are stored field by field, see foreach_simd.
+template <soa_component T>
+struct entity_map<T> {
+  using type = SoAIndexArray<T>;
+};
+};  // namespace detail
+
+template <typename T>
+using EntityMap = typename detail::entity_map<T>::type;
 using AnyMap = TypeMap<std::any>;
 
+namespace detail {
+template <typename T>
+struct component_pool {
+  using type = EntityMap<T>;
+};
+
+template <tag_component T>
+struct component_pool<T> {
+  using type = TagIndexArray<T>;
+};
+};  // namespace detail
+
+// Storage ComponentRegistry keeps T in. Tags get a TagIndexArray, whose
+// generations the registry's masks track.
+template <typename T>
+using ComponentPool = typename detail::component_pool<T>::type;
+
+namespace detail {
+// Pool a view over T iterates, const for read only const T.
+template <typename T>
+using view_pool_t =
+    std::conditional_t<std::is_const_v<T>,
+                       const ComponentPool<std::remove_const_t<T>>,
+                       ComponentPool<T>>;
+};  // namespace detail
+
+// Most component types one ComponentRegistry can hold, one mask bit each.
+constexpr std::size_t max_component_types{64};
+using ComponentMask = std::bitset<max_component_types>;
+
+namespace detail {
+// Writes of the included specs, from the writes of the fetched ones, see
+// is_included and is_fetched.
+template <auto Writes, class... Spec>
+constexpr write_flags<included_count<Spec...>> included_writes() {
+  write_flags<included_count<Spec...>> result{};
+  constexpr auto included = spec_positions<true, Spec...>();
+  constexpr auto fetched = spec_positions<false, Spec...>();
+  constexpr std::array<bool, sizeof...(Spec)> both{
+      (is_included<Spec> && is_fetched<Spec>)...};
+  for (std::size_t i = 0; i < sizeof...(Spec); i++) {
+    if (both[i])
+      result[included[i]] = Writes[fetched[i]];
+  }
+  return result;
+}
+
+// foreach_driven_by filter probing the sparse index of every other array.
+struct contains_all {};
+
+// Indices a chunk of parallel_foreach_arrays changed, per array. They are
+// logged once the chunks have joined, see GenerationalIndexArray::stamp_at.
+template <std::size_t Count>
+using stamped_indices = std::array<std::vector<GenerationalIndex>, Count>;
+
+// Visits the driver's packed range [begin, end), skipping ids for which
+// filter(id) is false. Any other filter than contains_all must only accept
+// ids present in every array. Components flagged in Writes are marked as
+// changed, see GenerationalIndexArray::touch_at, or only stamped and
+// collected in stamped for the caller to log.
+template <auto Writes, std::size_t Driver, typename Filter, typename Func,
+          class... ArrayType>
+void foreach_driven_by(
+    Filter& filter, Func& f, std::tuple<ArrayType&...> arrays,
+    std::size_t begin, std::size_t end,
+    stamped_indices<sizeof...(ArrayType)>* stamped = nullptr) {
+  auto& driver = std::get<Driver>(arrays);
+  const auto* ids = driver.indices().data();
+  auto* values = driver.values().data();
+  constexpr auto sequence = std::index_sequence_for<ArrayType...>{};
+  auto touch = [&]<std::size_t J>(auto& array, std::size_t position,
+                                  const Entity& id) {
+    if (stamped == nullptr) {
+      array.touch_at(position);
+    } else if (array.stamp_at(position) && array.logs_changes()) {
+      (*stamped)[J].push_back(id);
+    }
+  };
+  for (std::size_t i = begin; i < end; i++) {
+    const Entity& id = ids[i];
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      if constexpr (std::is_same_v<Filter, contains_all>) {
+        if (!((I == Driver || std::get<I>(arrays).contains(id)) && ...))
+          return;
+      } else {
+        if (!filter(id))
+          return;
+      }
+      auto fetch = [&]<std::size_t J>() -> decltype(auto) {
+        using Array = std::remove_reference_t<decltype(std::get<J>(arrays))>;
+        if constexpr (is_tag_array<Array>) {
+          return std::get<J>(arrays).get_unchecked(id);
+        } else if constexpr (J == Driver) {
+          if constexpr (Writes[J])
+            touch.template operator()<J>(driver, i, id);
+          return (values[i]);
+        } else if constexpr (Writes[J]) {
+          auto& array = std::get<J>(arrays);
+          const auto position = array.position_unchecked(id);
+          touch.template operator()<J>(array, position, id);
+          return (array.values()[position]);
+        } else {
+          return std::get<J>(arrays).get_unchecked(id);
+        }
+      };
+      f(id, fetch.template operator()<I>()...);
+    }(sequence);
+  }
+}
+
+// Index of the smallest array, which drives iteration. Tag arrays have no
+// packed ids to drive with and are never picked.
+template <class... ArrayType>
+std::size_t smallest_array(const ArrayType&... arrays) {
+  const std::array<std::size_t, sizeof...(ArrayType)> sizes{
+      (is_tag_array<ArrayType> ? std::numeric_limits<std::size_t>::max()
+                               : arrays.size())...};
+  return std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+}
+
+// Calls visit.template operator()<I>() for I == index.
+template <std::size_t Count, typename Visitor>
+void visit_index(std::size_t index, Visitor&& visit) {
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    ((index == I ? (visit.template operator()<I>(), true) : false) || ...);
+  }(std::make_index_sequence<Count>{});
+}
+
+// foreach_arrays with filter(id) deciding which of the smallest array's
+// entities are visited, see foreach_driven_by.
+template <auto Writes, typename Filter, typename Func, class... ArrayType>
+void foreach_arrays_filtered(Filter filter, Func&& f, ArrayType&... arrays) {
+  static_assert(!(soa_component<typename ArrayType::value_type> || ...),
+                "soa_layout components are iterated with foreach_simd.");
+  static_assert(!(is_tag_array<ArrayType> && ...),
+                "Tags only filter, a component must drive iteration.");
+  const std::size_t driver = smallest_array(arrays...);
+  visit_index<sizeof...(ArrayType)>(driver, [&]<std::size_t I>() {
+    auto tied = std::tie(arrays...);
+    using Driver = std::remove_reference_t<decltype(std::get<I>(tied))>;
+    if constexpr (!is_tag_array<Driver>) {
+      foreach_driven_by<Writes, I>(filter, f, tied, 0,
+                                   std::get<I>(tied).size());
+    }
+  });
+}
+
+// Calls f(entity, components...) for every entity present in all arrays.
+// Each array is resolved once; the smallest drives the loop over its packed
+// data and the others are only probed through their sparse index.
+template <typename Func, class... ArrayType>
+void foreach_arrays(Func&& f, ArrayType&... arrays) {
+  foreach_arrays_filtered<write_flags<sizeof...(ArrayType)>{}>(
+      contains_all{}, std::forward<Func>(f), arrays...);
+}
+
+// Chunks are rounded up to multiples of this many entities. That many
+// values of any size fill whole cache lines, and packed values and ticks
+// start on a line, so chunks never write to the same line of the driving
+// array.
+constexpr std::size_t parallel_grain_step{64};
+
+// foreach_arrays with the driver's packed range split into chunks of grain
+// entities, run on pool. Chunk boundaries only depend on the driver's size.
+// Changes of arrays that log them are collected per chunk and logged in
+// chunk order after the join. Only the driver is split on cache lines, other
+// written arrays are reached through their sparse index.
+template <auto Writes, typename Func, class... ArrayType>
+void parallel_foreach_arrays(ThreadPool& pool, std::size_t grain, Func&& f,
+                             ArrayType&... arrays) {
+  static_assert(!(is_tag_array<ArrayType> && ...),
+                "Tags only filter, a component must drive iteration.");
+  grain = std::max(grain, std::size_t{1});
+  grain = (grain + parallel_grain_step - 1) / parallel_grain_step *
+          parallel_grain_step;
+  const std::size_t driver = smallest_array(arrays...);
+  visit_index<sizeof...(ArrayType)>(driver, [&]<std::size_t I>() {
+    auto tied = std::tie(arrays...);
+    using Driver = std::remove_reference_t<decltype(std::get<I>(tied))>;
+    if constexpr (!is_tag_array<Driver>) {
+      const std::size_t size = std::get<I>(tied).size();
+      const std::size_t chunks = (size + grain - 1) / grain;
+      bool logged = false;
+      std::size_t j = 0;
+      (
+          [&] {
+            if constexpr (!is_tag_array<ArrayType>) {
+              logged |= Writes[j] && arrays.logs_changes();
+            }
+            j++;
+          }(),
+          ...);
+      std::vector<stamped_indices<sizeof...(ArrayType)>> stamped(
+          logged ? chunks : 0);
+      pool.parallel_for(chunks, [&](std::size_t chunk) {
+        const std::size_t begin = chunk * grain;
+        contains_all filter;
+        foreach_driven_by<Writes, I>(filter, f, tied, begin,
+                                     std::min(size, begin + grain),
+                                     logged ? &stamped[chunk] : nullptr);
+      });
+      for (const auto& chunk : stamped) {
+        j = 0;
+        (
+            [&] {
+              if constexpr (!is_tag_array<ArrayType>) {
+                arrays.log_stamped(chunk[j]);
+              }
+              j++;
+            }(),
+            ...);
+      }
+    }
+  });
+}
+};  // namespace detail
+
 class ECS {
  public:
-  inline Entity create() { return entity_allocator.allocate(); }
+  inline Entity create() {
+    ENGINE_PROFILE_COUNT(entities_created, 1);
+    return entity_allocator.allocate();
+  }
+
+  inline std::vector<Entity> create_many(std::size_t count) {
+    ENGINE_PROFILE_COUNT(entities_created, count);
+    return entity_allocator.allocate(count);
+  }
 
   inline bool destroy(Entity entity) {
-    return entity_allocator.deallocate(entity);
+    const bool destroyed = entity_allocator.deallocate(entity);
+    ENGINE_PROFILE_COUNT(entities_destroyed, destroyed);
+    return destroyed;
+  }
+
+  inline std::size_t destroy_many(std::span<const Entity> entities) {
+    const std::size_t destroyed = entity_allocator.deallocate(entities);
+    ENGINE_PROFILE_COUNT(entities_destroyed, destroyed);
+    return destroyed;
+  }
+
+  // Thread safe create. The entity is usable as a handle right away, but
+  // only becomes live at the next flush, see GenerationalIndexAllocator.
+  inline Entity reserve() { return entity_allocator.reserve(); }
+
+  inline std::size_t flush() {
+    const std::size_t created = entity_allocator.flush();
+    ENGINE_PROFILE_COUNT(entities_created, created);
+    return created;
+  }
+
+  inline bool is_live(const Entity& entity) const {
+    return entity_allocator.is_live(entity);
+  }
+
+  inline GenerationalIndexAllocator& allocator() { return entity_allocator; }
+
+  inline const GenerationalIndexAllocator& allocator() const {
+    return entity_allocator;
   }
 
  private:
   GenerationalIndexAllocator entity_allocator;
 };
 
+// Sparse set component storage. Every registered component type gets a bit
+// of ComponentMask, and each entity's mask records which pools hold it.
+// Empty component types are tags, kept as a bitset only, see TagIndexArray.
 class ComponentRegistry {
  public:
-  ComponentRegistry() = default;
+  // Pools and masks allocate their packed arrays from resource, except
+  // soa_layout pools, which keep their aligned allocator.
+  explicit ComponentRegistry(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : _resource(resource),
+        _masks(resource),
+        _frame_arena(std::make_unique<FrameArena>()) {}
 
   template <class ComponentType>
   inline void assert_registered() {
-    if (!_components.contains<ComponentType>()) {
+    if (!_slot_ids.contains<ComponentType>()) {
       throw std::runtime_error(
           "Adding component but component type was not registered.");
     }
@@ -43,92 +340,343 @@ class ComponentRegistry {
 
   template <class ComponentType>
   bool register_component() {
-    if (_components.contains<ComponentType>())
+    if (_slot_ids.contains<ComponentType>())
       return false;
-    _components.put<ComponentType>(EntityMap<ComponentType>());
+    if (_slots.size() == max_component_types) {
+      throw std::length_error("Too many component types registered.");
+    }
+    auto& slot = _slots.emplace_back();
+    slot.name = type_name(typeid(ComponentType));
+    if constexpr (std::is_constructible_v<ComponentPool<ComponentType>,
+                                          std::pmr::memory_resource*>) {
+      slot.pool = std::make_unique<ComponentPool<ComponentType>>(_resource);
+    } else {
+      slot.pool = std::make_unique<ComponentPool<ComponentType>>();
+    }
+    slot.pool->set_tick(_tick);
+    slot.pool->log_changes(_log_changes);
+    _slot_ids.put<ComponentType>(_slots.size() - 1);
     return true;
   }
 
   template <class ComponentType, typename... Args>
   bool add_component(Entity id, Args&&... args) {
     assert_registered<ComponentType>();
-    auto& entity_map = std::any_cast<EntityMap<ComponentType>&>(
-        _components.find<ComponentType>()->second);
-    return entity_map.emplace(id, std::forward<Args>(args)...);
+    const std::size_t slot = slot_of<ComponentType>();
+    auto& entity_map = pool_at<ComponentType>(slot);
+    if (!entity_map.emplace(id, std::forward<Args>(args)...))
+      return false;
+    if (!mark(id, slot)) {
+      entity_map.remove(id);
+      return false;
+    }
+    notify_add(slot, id);
+    ENGINE_PROFILE_COUNT(components_added, 1);
+    return true;
+  }
+
+  // Adds make(i) as the component of every ids[i] lacking one, reserving
+  // pool capacity once. Returns the number added.
+  template <class ComponentType, typename Generator>
+    requires std::invocable<Generator&, std::size_t>
+  std::size_t add_component_bulk(std::span<const Entity> ids, Generator make) {
+    const std::size_t slot = slot_of<ComponentType>();
+    auto& entity_map = pool_at<ComponentType>(slot);
+    const std::size_t first = entity_map.size();
+    std::size_t added = entity_map.emplace_bulk(ids, std::move(make));
+    std::vector<Entity> rejected;
+    for (std::size_t i = first; i < first + added; i++) {
+      const Entity id = entity_map.indices()[i];
+      if (!mark(id, slot))
+        rejected.push_back(id);
+    }
+    if (!rejected.empty()) {
+      added -= entity_map.remove_bulk(rejected);
+    }
+    if (!_slots[slot].observers.empty()) {
+      // groups reorder the pool while they are notified
+      const auto& indices = entity_map.indices();
+      const std::vector<Entity> added_ids(indices.begin() + first,
+                                          indices.begin() + first + added);
+      for (const auto& id : added_ids) {
+        notify_add(slot, id);
+      }
+    }
+    ENGINE_PROFILE_COUNT(components_added, added);
+    return added;
+  }
+
+  // Tags have no values, so make is never called.
+  template <tag_component ComponentType, typename Generator>
+    requires std::invocable<Generator&, std::size_t>
+  std::size_t add_component_bulk(std::span<const Entity> ids, Generator) {
+    std::size_t added = 0;
+    for (const auto& id : ids) {
+      added += add_component<ComponentType>(id);
+    }
+    return added;
+  }
+
+  template <class ComponentType>
+  std::size_t add_component_bulk(std::span<const Entity> ids,
+                                 std::span<const ComponentType> values) {
+    if (ids.size() != values.size()) {
+      throw std::invalid_argument("Bulk add needs one component per entity.");
+    }
+    return add_component_bulk<ComponentType>(
+        ids, [&](std::size_t i) { return values[i]; });
+  }
+
+  // Removes ComponentType from every entity in ids with one pass over the
+  // pool. Returns the number removed.
+  template <class ComponentType>
+  std::size_t remove_bulk(std::span<const Entity> ids) {
+    const std::size_t slot = slot_of<ComponentType>();
+    auto& entity_map = pool_at<ComponentType>(slot);
+    std::size_t removed = 0;
+    for (const auto& id : ids) {
+      if (holds<ComponentType>(slot, id)) {
+        notify_remove(slot, id);
+        unmark(id, slot);
+        if constexpr (tag_component<ComponentType>) {
+          removed += entity_map.erase(id);
+        }
+      }
+    }
+    if constexpr (!tag_component<ComponentType>) {
+      removed = entity_map.remove_bulk(ids);
+    }
+    ENGINE_PROFILE_COUNT(components_removed, removed);
+    return removed;
+  }
+
+  template <class ComponentType>
+  bool remove_component(Entity id) {
+    assert_registered<ComponentType>();
+    const std::size_t slot = slot_of<ComponentType>();
+    auto& entity_map = pool_at<ComponentType>(slot);
+    if (!holds<ComponentType>(slot, id))
+      return false;
+    notify_remove(slot, id);
+    entity_map.remove(id);
+    unmark(id, slot);
+    ENGINE_PROFILE_COUNT(components_removed, 1);
+    return true;
+  }
+
+  // Fills ComponentType's empty pool with packed arrays, e.g. from a
+  // snapshot, updating masks, queries and groups.
+  template <class ComponentType>
+  void assign_pool(std::span<const Entity> ids,
+                   CacheAlignedVector<ComponentType> values,
+                   std::span<const ComponentTicks> ticks) {
+    const std::size_t slot = slot_of<ComponentType>();
+    auto& entity_map = pool_at<ComponentType>(slot);
+    if (!entity_map.empty()) {
+      throw std::runtime_error("Assigning to a pool that is not empty.");
+    }
+    entity_map.assign(ids, std::move(values), ticks);
+    for (const auto& id : ids) {
+      if (!mark(id, slot)) {
+        throw std::runtime_error("Assigned entity is already in use.");
+      }
+      notify_add(slot, id);
+    }
+    ENGINE_PROFILE_COUNT(components_added, ids.size());
+  }
+
+  // Removes every component of id, only touching the pools in its mask.
+  bool remove_all(Entity id) {
+    const auto* found = _masks.find(id);
+    if (found == nullptr)
+      return false;
+    const ComponentMask signature = *found;
+    for (std::size_t slot = 0; slot < _slots.size(); slot++) {
+      if (!signature.test(slot))
+        continue;
+      notify_remove(slot, id);
+      _slots[slot].pool->erase(id);
+    }
+    _masks.remove(id);
+    ENGINE_PROFILE_COUNT(components_removed, signature.count());
+    return true;
   }
 
   template <class ComponentType>
   std::vector<Entity> has_component() {
     assert_registered<ComponentType>();
-    auto& entity_map = std::any_cast<EntityMap<ComponentType>&>(
-        _components.find<ComponentType>()->second);
-    return entity_map.indices();
+    if constexpr (tag_component<ComponentType>) {
+      std::vector<Entity> entities;
+      entities.reserve(pool<ComponentType>().size());
+      each_tagged<ComponentType>(
+          [&](const Entity& id) { entities.push_back(id); });
+      return entities;
+    } else {
+      const auto& indices = pool<ComponentType>().indices();
+      return {indices.begin(), indices.end()};
+    }
   }
 
   template <class FirstComponentType, class SecondComponentType,
             class... RestComponentType>
   std::vector<Entity> has_component() {
-    constexpr std::size_t num_component_types =
-        2 + sizeof...(RestComponentType);
-    std::array<std::vector<GenerationalIndex>, num_component_types>
-        entity_lists;
-
-    entity_lists[0] = has_component<FirstComponentType>();
-    if (entity_lists[0].empty())
-      return {};
-    entity_lists[1] = has_component<SecondComponentType>();
-    if (entity_lists[1].empty())
-      return {};
-
-    if constexpr (num_component_types > 2) {
-      // detect if empty entity list for at least one component
-      bool empty_entity_list = false;
-      int i = 2;
-      (
-          [&] {
-            if (!empty_entity_list) {
-              entity_lists[i] = has_component<RestComponentType>();
-              if (entity_lists[i].empty())
-                empty_entity_list = true;
-            }
-            i++;
-          }(),
-          ...);
-      if (empty_entity_list)
-        return {};
-    }
-
-    // Init result vector. Max size is where every entity is in every component list.
-    const std::size_t max_entities = [&] {
-      std::size_t sum = 0;
-      for (auto& e : entity_lists)
-        sum += e.size();
-      return sum;
-    }();
-
-    std::vector<Entity> unique_entities{max_entities};
-    // intersect on first 2
-    std::vector<Entity>::iterator it = std::set_intersection(
-        entity_lists[0].begin(), entity_lists[0].end(), entity_lists[1].begin(),
-        entity_lists[1].end(), unique_entities.begin());
-    // Compute intersect on rest of component types
-    if constexpr (num_component_types > 2) {
-      for (std::size_t i = 2; i < num_component_types; i++) {
-        it = std::set_intersection(
-            unique_entities.begin(), unique_entities.end(),
-            entity_lists[i].begin(), entity_lists[i].end(),
-            unique_entities.begin());
-      }
+    std::vector<Entity> entities;
+    each_query<detail::write_flags<detail::fetched_count<
+                   FirstComponentType, SecondComponentType,
+                   RestComponentType...>>{},
+               FirstComponentType, SecondComponentType, RestComponentType...>(
+        [&](const Entity& id, const auto&...) { entities.push_back(id); },
+        _tick - 1);
+    return entities;
+  }
+
+  // has_component allocating the result from resource, e.g. frame_arena()
+  // to keep per frame queries off the heap.
+  template <class... ComponentType>
+  std::pmr::vector<Entity> has_component(std::pmr::memory_resource* resource) {
+    std::pmr::vector<Entity> entities{resource};
+    if constexpr (sizeof...(ComponentType) == 1 &&
+                  !(tag_component<ComponentType> && ...)) {
+      const auto& indices = pool<ComponentType...>().indices();
+      entities.assign(indices.begin(), indices.end());
+    } else {
+      each_query<detail::write_flags<detail::fetched_count<ComponentType...>>{},
+                 ComponentType...>(
+          [&](const Entity& id, const auto&...) { entities.push_back(id); },
+          _tick - 1);
     }
-    unique_entities.resize(it - unique_entities.begin());
+    return entities;
+  }
+
+  // Mask with the bits of ...ComponentType set, filters count as their
+  // component type.
+  template <class... ComponentType>
+  ComponentMask mask() {
+    ComponentMask result;
+    (result.set(slot_of<detail::filtered_component_t<ComponentType>>()), ...);
+    return result;
+  }
 
-    return unique_entities;
+  // Component types of id, empty for entities without components.
+  inline ComponentMask signature(const Entity& id) const {
+    const auto* found = _masks.find(id);
+    return found != nullptr ? *found : ComponentMask{};
+  }
+
+  // Whether id has every component in with and none in without.
+  inline bool matches(const Entity& id, const ComponentMask& with,
+                      const ComponentMask& without = {}) const {
+    const ComponentMask current = signature(id);
+    return (current & with) == with && (current & without).none();
+  }
+
+  // Also takes With and Without filters, Optional ones are ignored.
+  template <class... ComponentType>
+  bool has(const Entity& id) {
+    return matches(
+        id,
+        presence_mask<detail::Presence::required, ComponentType...>() |
+            presence_mask<detail::Presence::with, ComponentType...>(),
+        presence_mask<detail::Presence::without, ComponentType...>());
+  }
+
+  // Calls f with every entity's ...ComponentType, see detail::foreach_arrays.
+  // Added<T> and Changed<T> only match entities whose T was added or changed
+  // after since, which defaults to the changes made during the current tick.
+  // Components f takes by non-const reference are marked as changed.
+  // With<T> and Without<T> only match entities with or without T, and
+  // Optional<T> passes T as a pointer, nullptr when absent. They are tested
+  // per entity of the smallest pool, building no entity lists.
+  template <class... ComponentType, typename Func>
+  void each(Func f) {
+    each<ComponentType...>(std::move(f), _tick - 1);
+  }
+
+  template <class... ComponentType, typename Func>
+  void each(Func f, Tick since) {
+    constexpr auto writes =
+        detail::written_components<Func,
+                                   detail::fetched_count<ComponentType...>>();
+    QueryCounter<ComponentType...> counter;
+    each_query<writes, ComponentType...>(
+        [&f, &counter](const Entity&, auto&... components) {
+          counter.visit();
+          f(components...);
+        },
+        since);
+  }
+
+  // Lazy range of std::tuple<Entity, ComponentType&...> over the entities
+  // with every ...ComponentType, see View. Allocates nothing, so loops that
+  // stop early only pay for the entities they visit. Non-const component
+  // types are marked as changed when dereferenced.
+  template <class... ComponentType>
+  View<detail::view_pool_t<ComponentType>...> view() {
+    static_assert(!((detail::has_tick_filter<ComponentType> ||
+                     detail::has_presence_filter<ComponentType>) ||
+                    ...),
+                  "Views take component types, filter with each instead.");
+    return View<detail::view_pool_t<ComponentType>...>{
+        pool<std::remove_const_t<ComponentType>>()...};
+  }
+
+  // Tick stamped on components added or changed from now on.
+  inline Tick tick() const { return _tick; }
+
+  // Continues from tick, e.g. after loading a snapshot.
+  void set_tick(Tick tick) {
+    _tick = tick;
+    for (auto& slot : _slots) {
+      slot.pool->set_tick(_tick);
+    }
+  }
+
+  // Makes every pool record the components removed from and changed in it
+  // with their tick, see GenerationalIndexArray::removals and changes.
+  void log_changes(bool enabled) {
+    _log_changes = enabled;
+    for (auto& slot : _slots) {
+      slot.pool->log_changes(enabled);
+    }
+  }
+
+  // Drops the removals and changes recorded at or before tick.
+  void trim_changes(Tick tick) {
+    for (auto& slot : _slots) {
+      slot.pool->trim_changes(tick);
+    }
+  }
+
+  // Starts a new tick, e.g. once per frame. Returns the new tick.
+  Tick advance_tick() {
+    _tick++;
+    for (auto& slot : _slots) {
+      slot.pool->set_tick(_tick);
+    }
+    return _tick;
+  }
+
+  // Scratch memory for the current frame. Anything allocated from it must
+  // not outlive the next reset_frame.
+  inline FrameArena& frame_arena() { return *_frame_arena; }
+
+  // Frees everything allocated from frame_arena(), once per frame.
+  inline void reset_frame() { _frame_arena->reset(); }
+
+  // Size and memory of every pool, and of the entity masks.
+  std::vector<PoolStats> pool_stats() const {
+    std::vector<PoolStats> stats;
+    stats.reserve(_slots.size() + 1);
+    for (const auto& slot : _slots) {
+      stats.push_back({slot.name, slot.pool->stats()});
+    }
+    stats.push_back({"ComponentMask", _masks.stats()});
+    return stats;
   }
 
   template <class ComponentType>
   auto component_accessor() {
-    auto& entity_map = std::any_cast<EntityMap<ComponentType>&>(
-        _components.find<ComponentType>()->second);
+    auto& entity_map = pool<ComponentType>();
     return [&](Entity id) -> ComponentType& {
       return entity_map.get(id);
     };
@@ -136,23 +684,351 @@ class ComponentRegistry {
 
   template <class ComponentType>
   ComponentType& get_component(Entity id) {
-    auto& entity_map = std::any_cast<EntityMap<ComponentType>&>(
-        _components.find<ComponentType>()->second);
-    return entity_map.get(id);
+    return pool<ComponentType>().get(id);
+  }
+
+  // Shorthand for get_component.
+  template <class ComponentType>
+  inline ComponentType& get(Entity id) {
+    return get_component<ComponentType>(id);
+  }
+
+  // Adding or removing through the pool directly bypasses the masks.
+  template <class ComponentType>
+  ComponentPool<ComponentType>& pool() {
+    return pool_at<ComponentType>(slot_of<ComponentType>());
+  }
+
+  // Persistent query over ...ComponentType. Created and filled on first use,
+  // then kept up to date by add_component and remove_component.
+  template <class... ComponentType>
+  Query<ComponentType...>& query() {
+    static_assert(!(tag_component<ComponentType> || ...),
+                  "Queries cannot watch tags, filter with each instead.");
+    using QueryType = Query<ComponentType...>;
+    auto it = _queries.find<QueryType>();
+    if (it != _queries.end()) {
+      return static_cast<QueryType&>(*it->second);
+    }
+    (assert_registered<ComponentType>(), ...);
+    auto query = std::make_unique<QueryType>(pool<ComponentType>()...);
+    auto& result = *query;
+    (_slots[slot_of<ComponentType>()].observers.push_back(&result), ...);
+    _queries.put<QueryType>(std::move(query));
+    return result;
+  }
+
+  // Group owning ...ComponentType's pools, created on first use. Afterwards
+  // each<ComponentType...> scans the group's prefix of every pool instead of
+  // probing pools. A pool can be owned by one group only.
+  template <class... ComponentType>
+  Group<ComponentType...>& group() {
+    static_assert(!(tag_component<ComponentType> || ...),
+                  "Tags have no packed arrays for a group to own.");
+    using GroupType = Group<ComponentType...>;
+    auto it = _queries.find<GroupType>();
+    if (it != _queries.end()) {
+      return static_cast<GroupType&>(*it->second);
+    }
+    const ComponentMask owned = mask<ComponentType...>();
+    for (std::size_t slot = 0; slot < _slots.size(); slot++) {
+      if (owned.test(slot) && _slots[slot].group != nullptr) {
+        throw std::runtime_error("Component type is already in a group.");
+      }
+    }
+    auto group = std::make_unique<GroupType>(pool<ComponentType>()...);
+    auto& result = *group;
+    (_slots[slot_of<ComponentType>()].observers.push_back(&result), ...);
+    ((_slots[slot_of<ComponentType>()].group = &result), ...);
+    ((_slots[slot_of<ComponentType>()].group_mask = owned), ...);
+    _queries.put<GroupType>(std::move(group));
+    return result;
   }
 
  private:
-  AnyMap _components;
-};
+  struct Slot {
+    std::string name;
+    std::unique_ptr<IndexArrayBase> pool;
+    // Queries and groups watching this component type.
+    std::vector<QueryBase*> observers;
+    // Group owning the pool, and all the types it owns.
+    GroupBase* group = nullptr;
+    ComponentMask group_mask;
+  };
+
+  template <class ComponentType>
+  std::size_t slot_of() const {
+    const auto* slot = _slot_ids.get<ComponentType>();
+    if (slot == nullptr) {
+      throw std::runtime_error("Component type was not registered.");
+    }
+    return *slot;
+  }
+
+  template <class ComponentType>
+  inline ComponentPool<ComponentType>& pool_at(std::size_t slot) {
+    return static_cast<ComponentPool<ComponentType>&>(*_slots[slot].pool);
+  }
+
+  // Whether id has ComponentType. Tag bits don't record generations, so tags
+  // are looked up in the masks.
+  template <class ComponentType>
+  inline bool holds(std::size_t slot, const Entity& id) const {
+    if constexpr (tag_component<ComponentType>) {
+      const auto* found = _masks.find(id);
+      return found != nullptr && found->test(slot);
+    } else {
+      return static_cast<const ComponentPool<ComponentType>&>(
+                 *_slots[slot].pool)
+          .contains(id);
+    }
+  }
 
-template <class... ComponentType, typename Func>
-void foreach (ComponentRegistry& registry, Func f) {
-  // get entities which have ...ComponentType
-  auto entities = registry.has_component<ComponentType...>();
-  // Get components for each entitiy and call func
-  for (const auto& entity : entities) {
-    f(registry.get_component<ComponentType>(entity)...);
+  // Calls f(entity) for every entity with all of ...TagType, ANDing their
+  // bitsets a word at a time. The masks provide the generations.
+  template <class... TagType, typename Func>
+  void each_tagged(Func&& f) {
+    detail::foreach_common_index(
+        std::array{pool<TagType>().words()...},
+        [&](GenerationalIndexType index) {
+          if (const auto* id = _masks.stored_index(index))
+            f(*id);
+        });
   }
+
+  // Multiple types are matched through the masks, one lookup per entity of
+  // the smallest pool instead of one per other pool. Tags never drive, unless
+  // there are only tags. Entities with any component in without are skipped.
+  template <auto Writes, class... Spec, typename Func>
+  void each_entity(Func&& f, Tick since, const ComponentMask& without = {}) {
+    constexpr bool filtered = (detail::has_tick_filter<Spec> || ...);
+    constexpr bool tagged =
+        (tag_component<detail::filtered_component_t<Spec>> || ...);
+    static_assert(!((detail::has_tick_filter<Spec> &&
+                     tag_component<detail::filtered_component_t<Spec>>) ||
+                    ...),
+                  "Tags have no ticks to filter on.");
+    if constexpr ((tag_component<detail::filtered_component_t<Spec>> &&
+                   ...)) {
+      auto pools = std::tie(pool<detail::filtered_component_t<Spec>>()...);
+      each_tagged<detail::filtered_component_t<Spec>...>(
+          [&](const Entity& id) {
+            if (without.any() && (signature(id) & without).any())
+              return;
+            std::apply(
+                [&](auto&... tags) { f(id, tags.get_unchecked(id)...); },
+                pools);
+          });
+    } else {
+      if constexpr (sizeof...(Spec) == 1 && !filtered) {
+        if (without.none()) {
+          detail::foreach_arrays_filtered<Writes>(
+              detail::contains_all{}, std::forward<Func>(f),
+              pool<detail::filtered_component_t<Spec>>()...);
+          return;
+        }
+      } else if constexpr (sizeof...(Spec) > 1 && !tagged) {
+        if (without.none() && each_grouped<Writes, Spec...>(f, since))
+          return;
+      }
+      const ComponentMask required = mask<Spec...>();
+      auto pools = std::tie(pool<detail::filtered_component_t<Spec>>()...);
+      detail::foreach_arrays_filtered<Writes>(
+          [&](const Entity& id) {
+            const auto* found = _masks.find(id);
+            if (found == nullptr || (*found & required) != required ||
+                (*found & without).any())
+              return false;
+            if constexpr (filtered) {
+              return [&]<std::size_t... I>(std::index_sequence<I...>) {
+                return (ticks_match<Spec>(std::get<I>(pools), id, since) &&
+                        ...);
+              }(std::index_sequence_for<Spec...>{});
+            }
+            return true;
+          },
+          std::forward<Func>(f), pool<detail::filtered_component_t<Spec>>()...);
+    }
+  }
+
+  // each_entity over the included specs, see detail::is_included. Without
+  // is tested on the mask each_entity looks up anyway, Optional components
+  // are looked up per match. Writes are per fetched spec.
+  template <auto Writes, class... Spec, typename Func>
+  void each_query(Func&& f, Tick since) {
+    if constexpr (!(detail::has_presence_filter<Spec> || ...)) {
+      each_entity<Writes, Spec...>(std::forward<Func>(f), since);
+    } else {
+      static_assert(detail::included_count<Spec...> > 0,
+                    "A query needs a component or With filter to iterate.");
+      const ComponentMask without =
+          presence_mask<detail::Presence::without, Spec...>();
+      auto optionals = std::make_tuple(optional_pool<Spec>()...);
+      auto visit = [&](const Entity& id, auto&... components) {
+        auto included = std::forward_as_tuple(components...);
+        auto argument = [&]<std::size_t I>() {
+          using S = std::tuple_element_t<I, std::tuple<Spec...>>;
+          if constexpr (detail::presence<S> == detail::Presence::required) {
+            return std::forward_as_tuple(std::get<
+                detail::spec_positions<true, Spec...>()[I]>(included));
+          } else if constexpr (detail::presence<S> ==
+                               detail::Presence::optional) {
+            return std::make_tuple(find_optional<
+                S, Writes[detail::spec_positions<false, Spec...>()[I]]>(
+                *std::get<I>(optionals), id));
+          } else {
+            return std::tuple<>{};
+          }
+        };
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+          auto arguments = std::tuple_cat(std::forward_as_tuple(id),
+                                          argument.template operator()<I>()...);
+          std::apply(f, arguments);
+        }(std::index_sequence_for<Spec...>{});
+      };
+      [&]<class... Included>(std::type_identity<std::tuple<Included...>>) {
+        each_entity<detail::included_writes<Writes, Spec...>(), Included...>(
+            visit, since, without);
+      }(std::type_identity<detail::included_specs<Spec...>>{});
+    }
+  }
+
+  // Mask of the specs with presence P.
+  template <detail::Presence P, class... Spec>
+  ComponentMask presence_mask() {
+    ComponentMask result;
+    ((detail::presence<Spec> == P
+          ? void(result.set(slot_of<detail::filtered_component_t<Spec>>()))
+          : void()),
+     ...);
+    return result;
+  }
+
+  // Pool of an Optional spec, nullptr for other specs.
+  template <class Spec>
+  auto optional_pool() {
+    if constexpr (detail::presence<Spec> == detail::Presence::optional) {
+      return &pool<detail::filtered_component_t<Spec>>();
+    } else {
+      return nullptr;
+    }
+  }
+
+  // id's component of an Optional spec, or nullptr.
+  template <class Spec, bool Write, class Pool>
+  auto* find_optional(Pool& pool, const Entity& id) {
+    using T = detail::filtered_component_t<Spec>;
+    if constexpr (tag_component<T>) {
+      return holds<T>(slot_of<T>(), id) ? &pool.get_unchecked(id) : nullptr;
+    } else {
+      const auto position = pool.position(id);
+      if (position == PagedSparseArray::tombstone)
+        return static_cast<T*>(nullptr);
+      if constexpr (Write)
+        pool.touch_at(position);
+      return &pool.values()[position];
+    }
+  }
+
+  // each_entity over the group owning exactly Spec's pools, if there is one.
+  template <auto Writes, class... Spec, typename Func>
+  bool each_grouped(Func& f, Tick since) {
+    using First = detail::filtered_component_t<
+        std::tuple_element_t<0, std::tuple<Spec...>>>;
+    const auto& slot = _slots[slot_of<First>()];
+    if (slot.group == nullptr || slot.group_mask != mask<Spec...>())
+      return false;
+    auto pools = std::tie(pool<detail::filtered_component_t<Spec>>()...);
+    const std::size_t size = slot.group->size();
+    const auto* ids = std::get<0>(pools).indices().data();
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      auto values = std::make_tuple(std::get<I>(pools).values().data()...);
+      auto ticks = std::make_tuple(std::get<I>(pools).ticks().data()...);
+      for (std::size_t i = 0; i < size; i++) {
+        if (!(detail::ticks_match<Spec>(std::get<I>(ticks)[i], since) && ...))
+          continue;
+        ((Writes[I] ? std::get<I>(pools).touch_at(i) : void()), ...);
+        f(ids[i], std::get<I>(values)[i]...);
+      }
+    }(std::index_sequence_for<Spec...>{});
+    return true;
+  }
+
+  template <class Spec, class Pool>
+  static bool ticks_match(const Pool& pool, const Entity& id, Tick since) {
+    if constexpr (detail::has_tick_filter<Spec>) {
+      return detail::ticks_match<Spec>(
+          pool.ticks()[pool.position_unchecked(id)], since);
+    }
+    return true;
+  }
+
+  // Sets slot's bit in id's mask. False when an older generation of id
+  // still owns the mask, i.e. it was destroyed without removing components.
+  inline bool mark(const Entity& id, std::size_t slot) {
+    if (auto* found = _masks.find(id)) {
+      found->set(slot);
+      return true;
+    }
+    return _masks.emplace(id, ComponentMask{}.set(slot));
+  }
+
+  inline void unmark(const Entity& id, std::size_t slot) {
+    auto* found = _masks.find(id);
+    if (found != nullptr && found->reset(slot).none()) {
+      _masks.remove(id);
+    }
+  }
+
+  inline void notify_add(std::size_t slot, Entity id) {
+    for (auto* observer : _slots[slot].observers) {
+      observer->on_add(id);
+    }
+  }
+
+  inline void notify_remove(std::size_t slot, Entity id) {
+    for (auto* observer : _slots[slot].observers) {
+      observer->on_remove(id);
+    }
+  }
+
+  std::pmr::memory_resource* _resource;
+  TypeMap<std::size_t> _slot_ids;
+  std::vector<Slot> _slots;
+  GenerationalIndexArray<ComponentMask> _masks;
+  TypeMap<std::unique_ptr<QueryBase>> _queries;
+  Tick _tick = 1;
+  bool _log_changes = false;
+  std::unique_ptr<FrameArena> _frame_arena;
+};
+
+// Works with any registry providing each<...ComponentType>(f), such as
+// ComponentRegistry and World.
+template <class... ComponentType, class RegistryType, typename Func>
+void foreach (RegistryType& registry, Func f) {
+  registry.template each<ComponentType...>(f);
+}
+
+// foreach with Added/Changed filters matching changes after since.
+template <class... ComponentType, class RegistryType, typename Func>
+void foreach (RegistryType& registry, Func f, Tick since) {
+  registry.template each<ComponentType...>(f, since);
+}
+
+constexpr std::size_t default_parallel_grain{4096};
+
+// foreach split across pool's threads in chunks of grain entities. f is
+// called concurrently, so it may only write to the components passed to it.
+template <class... ComponentType, class RegistryType, typename Func>
+void parallel_foreach(RegistryType& registry, Func f,
+                      std::size_t grain = default_parallel_grain,
+                      ThreadPool& pool = default_thread_pool()) {
+  constexpr auto writes =
+      detail::written_components<Func, sizeof...(ComponentType)>();
+  detail::parallel_foreach_arrays<writes>(
+      pool, grain,
+      [&f](const Entity&, auto&... components) { f(components...); },
+      registry.template pool<ComponentType>()...);
 }
 
 class ResourceRegistry {
@@ -161,16 +1037,66 @@ class ResourceRegistry {
 
   template <class ResourceType, typename... Args>
   bool register_resource(Args&&... args) {
-    return _resources.emplace<ResourceType>(std::forward<Args>(args)...);
+    return _resources.emplace<ResourceType>(std::in_place_type<ResourceType>,
+                                            std::forward<Args>(args)...);
+  }
+
+  // ResourceType's resource. Throws if it was not registered.
+  template <class ResourceType>
+  ResourceType& get() {
+    auto* resource = find<ResourceType>();
+    if (resource == nullptr) {
+      throw std::runtime_error("Resource type was not registered.");
+    }
+    return *resource;
+  }
+
+  template <class ResourceType>
+  const ResourceType& get() const {
+    return const_cast<ResourceRegistry*>(this)->get<ResourceType>();
+  }
+
+  // ResourceType's resource, or nullptr.
+  template <class ResourceType>
+  ResourceType* find() {
+    auto* resource = _resources.get<ResourceType>();
+    return resource != nullptr ? std::any_cast<ResourceType>(resource)
+                               : nullptr;
+  }
+
+  template <class ResourceType>
+  bool contains() const {
+    return _resources.contains<ResourceType>();
   }
 
  private:
   AnyMap _resources;
 };
 
-struct Registry {
-  ComponentRegistry components;
+// ComponentStorage picks the component storage backend, for example
+// ComponentRegistry (sparse sets) or ArchetypeRegistry (archetype chunks).
+// Entities created here are destroyed together with their components.
+template <class ComponentStorage>
+struct BasicRegistry {
+  ComponentStorage components;
   ResourceRegistry resources;
+  ECS entities;
+
+  inline Entity create() { return entities.create(); }
+
+  inline std::vector<Entity> create_many(std::size_t count) {
+    return entities.create_many(count);
+  }
+
+  // Removes id's components, then frees id. False if id is not alive.
+  bool destroy(Entity id) {
+    if (!entities.destroy(id))
+      return false;
+    components.remove_all(id);
+    return true;
+  }
 };
+
+using Registry = BasicRegistry<ComponentRegistry>;
 };  // namespace engine
 #endif
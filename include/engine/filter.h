@@ -0,0 +1,147 @@
+#ifndef ENGINE_FILTER_H
+#define ENGINE_FILTER_H
+
+#include <engine/generational_index.h>
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace engine {
+
+// Query filters, used in place of a component type, e.g.
+// each<Changed<Position>, Velocity>(f). The filtered component is still
+// passed to f, but only entities matching the filter are visited.
+
+// T was added after the since tick.
+template <class T>
+struct Added {};
+
+// T was added or mutably accessed after the since tick.
+template <class T>
+struct Changed {};
+
+// Presence filters, tested on each candidate's component mask while the
+// smallest pool is walked, e.g. each<Position, Without<Dead>>(f).
+
+// The entity has T, which is not passed to f.
+template <class T>
+struct With {};
+
+// The entity does not have T. Nothing is passed to f.
+template <class T>
+struct Without {};
+
+// T is passed to f as a pointer, nullptr for entities without it. Doesn't
+// affect which entities are visited.
+template <class T>
+struct Optional {};
+
+namespace detail {
+enum class TickFilter { none, added, changed };
+
+// Component type behind a filter and how its ticks are matched.
+template <class Spec>
+struct component_filter {
+  using type = Spec;
+  static constexpr TickFilter ticks = TickFilter::none;
+};
+
+template <class T>
+struct component_filter<Added<T>> {
+  using type = T;
+  static constexpr TickFilter ticks = TickFilter::added;
+};
+
+template <class T>
+struct component_filter<Changed<T>> {
+  using type = T;
+  static constexpr TickFilter ticks = TickFilter::changed;
+};
+
+template <class T>
+struct component_filter<With<T>> : component_filter<T> {};
+
+template <class T>
+struct component_filter<Without<T>> : component_filter<T> {};
+
+template <class T>
+struct component_filter<Optional<T>> : component_filter<T> {};
+
+template <class Spec>
+using filtered_component_t = typename component_filter<Spec>::type;
+
+enum class Presence { required, with, without, optional };
+
+// How a query spec takes part in matching and in f's arguments.
+template <class Spec>
+constexpr Presence presence = Presence::required;
+
+template <class T>
+constexpr Presence presence<With<T>> = Presence::with;
+
+template <class T>
+constexpr Presence presence<Without<T>> = Presence::without;
+
+template <class T>
+constexpr Presence presence<Optional<T>> = Presence::optional;
+
+template <class Spec>
+constexpr bool has_presence_filter = presence<Spec> != Presence::required;
+
+// Iterated pools, which must hold the entity.
+template <class Spec>
+constexpr bool is_included = presence<Spec> == Presence::required ||
+                             presence<Spec> == Presence::with;
+
+// Passed to f.
+template <class Spec>
+constexpr bool is_fetched = presence<Spec> == Presence::required ||
+                            presence<Spec> == Presence::optional;
+
+template <class... Spec>
+constexpr std::size_t fetched_count{(std::size_t{is_fetched<Spec>} + ... + 0)};
+
+template <class... Spec>
+constexpr std::size_t included_count{
+    (std::size_t{is_included<Spec>} + ... + 0)};
+
+// std::tuple of the included specs.
+template <class... Spec>
+using included_specs = decltype(std::tuple_cat(
+    std::declval<std::conditional_t<is_included<Spec>, std::tuple<Spec>,
+                                    std::tuple<>>>()...));
+
+// For each of Spec, its position among the included specs, or among the
+// fetched ones, see is_included and is_fetched.
+template <bool Included, class... Spec>
+constexpr std::array<std::size_t, sizeof...(Spec)> spec_positions() {
+  std::array<std::size_t, sizeof...(Spec)> positions{};
+  std::size_t next = 0;
+  std::size_t i = 0;
+  ((positions[i++] = next,
+    next += Included ? is_included<Spec> : is_fetched<Spec>),
+   ...);
+  return positions;
+}
+
+template <class Spec>
+constexpr bool has_tick_filter =
+    component_filter<Spec>::ticks != TickFilter::none;
+
+template <class Spec>
+constexpr bool ticks_match(const ComponentTicks& ticks, Tick since) {
+  switch (component_filter<Spec>::ticks) {
+    case TickFilter::added:
+      return ticks.added > since;
+    case TickFilter::changed:
+      return ticks.changed > since;
+    case TickFilter::none:
+      break;
+  }
+  return true;
+}
+};  // namespace detail
+};  // namespace engine
+#endif
@@ -2,13 +2,20 @@
 #define ENGINE_GENERATIONAL_INDEX_H
 
 #include <fmt/core.h>
+#include <algorithm>
 #include <array>
-#include <bitset>
+#include <atomic>
 #include <cassert>
+#include <compare>
 #include <cstddef>
+#include <concepts>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
-#include <queue>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -17,136 +24,711 @@ namespace engine {
 
 using GenerationalIndexType = std::uint32_t;
 
-class GenerationalIndex {
+// Index and generation packed into one 64 bit value, the index in the low
+// IndexBits and the generation in the GenerationBits above it. Trivially
+// copyable, so handle arrays can be memcpy'd or placed in shared memory.
+// Generations wrap around modulo 2^GenerationBits.
+template <unsigned IndexBits, unsigned GenerationBits>
+  requires(IndexBits > 0 && IndexBits <= 32 && GenerationBits > 0 &&
+           GenerationBits <= 32)
+class BasicGenerationalIndex {
  public:
-  GenerationalIndex() = default;
-  GenerationalIndex(GenerationalIndexType index, std::uint32_t generation);
+  static constexpr unsigned index_bits = IndexBits;
+  static constexpr unsigned generation_bits = GenerationBits;
+  static constexpr GenerationalIndexType max_index =
+      static_cast<GenerationalIndexType>((std::uint64_t{1} << IndexBits) - 1);
+  static constexpr std::uint32_t max_generation =
+      static_cast<std::uint32_t>((std::uint64_t{1} << GenerationBits) - 1);
 
-  inline GenerationalIndexType index() const { return _index; }
+  constexpr BasicGenerationalIndex() = default;
+  constexpr BasicGenerationalIndex(GenerationalIndexType index,
+                                   std::uint32_t generation)
+      : _value((index & max_index) |
+               (std::uint64_t{generation & max_generation} << IndexBits)) {}
 
-  inline std::uint32_t generation() const { return _generation; }
+  constexpr GenerationalIndexType index() const {
+    return static_cast<GenerationalIndexType>(_value & max_index);
+  }
+
+  constexpr std::uint32_t generation() const {
+    return static_cast<std::uint32_t>(_value >> IndexBits);
+  }
+
+  // The packed representation, see from_value.
+  constexpr std::uint64_t value() const { return _value; }
+
+  static constexpr BasicGenerationalIndex from_value(std::uint64_t value) {
+    BasicGenerationalIndex result;
+    result._value = value;
+    return result;
+  }
 
   struct HashFunction {
-    inline size_t operator()(const GenerationalIndex& index) const {
-      static_assert(
-          std::is_same<GenerationalIndexType, std::uint32_t>::value,
-          "GenerationalIndex hash function only defined for uint32_t.");
-      size_t index_hash = std::hash<GenerationalIndexType>()(index._index);
-      size_t generation_hash = std::hash<std::uint32_t>()(index._generation)
-                               << 1;
-      return index_hash ^ generation_hash;
+    inline std::size_t operator()(const BasicGenerationalIndex& index) const {
+      return std::hash<std::uint64_t>()(index._value);
     }
   };
 
-  virtual ~GenerationalIndex() = default;
+  friend constexpr bool operator==(const BasicGenerationalIndex&,
+                                   const BasicGenerationalIndex&) = default;
+
+  // Orders by index, then generation.
+  friend constexpr std::strong_ordering operator<=>(
+      const BasicGenerationalIndex& a, const BasicGenerationalIndex& b) {
+    if (auto order = a.index() <=> b.index(); order != 0)
+      return order;
+    return a.generation() <=> b.generation();
+  }
 
  private:
-  GenerationalIndexType _index;
-  std::uint32_t _generation;
+  std::uint64_t _value = 0;
 };
 
-inline bool operator==(const GenerationalIndex& a, const GenerationalIndex& b) {
-  return (a.index() && b.index()) && (a.generation() && b.generation());
-}
-
-inline bool operator<(const GenerationalIndex& a, const GenerationalIndex& b) {
-  return a.index() < b.index();
-}
+using GenerationalIndex = BasicGenerationalIndex<32, 32>;
+static_assert(sizeof(GenerationalIndex) == sizeof(std::uint64_t));
+static_assert(std::is_trivially_copyable_v<GenerationalIndex>);
 
+// Slot of a GenerationalIndexAllocator. version is odd while the slot is
+// live and its generation is version / 2. Free slots link to the next one.
 struct AllocatorEntry {
-  std::uint32_t generation = 0;
-  bool is_live = true;
+  std::uint32_t version = 1;
+  GenerationalIndexType next_free = 0;
+};
+
+// New version of an allocator slot, see GenerationalIndexAllocator::patch.
+struct SlotVersion {
+  GenerationalIndexType index;
+  std::uint32_t version;
 };
 
+// Hands out indices, recycling freed ones first in the order they were
+// freed, so a batch of freed slots is reused as a batch. The free list is
+// threaded through the entries. A slot whose generation would wrap around
+// is retired instead of being reused.
+//
+// reserve is the only member safe to call from several threads at once.
+// Reserved indices become live at the next flush, which every other
+// mutating member does first.
 class GenerationalIndexAllocator {
  public:
-  GenerationalIndexAllocator() = default;
+  // Terminates the free list, so this index is never handed out.
+  static constexpr GenerationalIndexType free_list_end{
+      GenerationalIndex::max_index};
+
+  // Largest generation a version can encode.
+  static constexpr std::uint32_t max_last_generation{
+      std::min<std::uint32_t>(GenerationalIndex::max_generation,
+                              std::numeric_limits<std::uint32_t>::max() / 2 -
+                                  1)};
+
+  // Slots are retired once freed at last_generation.
+  explicit GenerationalIndexAllocator(
+      std::uint32_t last_generation = max_last_generation)
+      : _last_generation(std::min(last_generation, max_last_generation)) {}
   virtual ~GenerationalIndexAllocator() = default;
 
   GenerationalIndex allocate();
+  // Allocates count indices at once, recycled ones first.
+  std::vector<GenerationalIndex> allocate(std::size_t count);
   bool deallocate(const GenerationalIndex& index);
+  // Deallocates every live index. Returns the number freed.
+  std::size_t deallocate(std::span<const GenerationalIndex> indices);
+
+  // Lock free: pops the free list head with a CAS, or claims a fresh index
+  // past the entries. reserve may run concurrently with other reserve calls
+  // only; no other member, flush and deallocate included, may run at the
+  // same time.
+  GenerationalIndex reserve();
+  // Makes every reserved index live. Returns the number materialized.
+  std::size_t flush();
 
   inline bool is_live(const GenerationalIndex& index) const {
-    return _entries[index.index()].is_live;
+    if (index.index() >= _entries.size())
+      return false;
+    // comparing with generation * 2 + 1 would wrap for forged generations
+    const auto version = _entries[index.index()].version;
+    return (version & 1) != 0 && version / 2 == index.generation();
   }
 
   inline std::size_t allocated() const { return _entries.size(); }
 
-  inline std::size_t free() const { return _free.size(); }
+  inline std::size_t free() const { return _free_count; }
+
+  inline std::size_t retired() const { return _retired; }
+
+  inline std::span<const AllocatorEntry> entries() const { return _entries; }
+
+  // Replaces the state with entries, e.g. from a snapshot. Free slots are
+  // recycled in index order afterwards.
+  void assign(std::span<const AllocatorEntry> entries);
+
+  // Follows an allocator this one mirrors, which grew to allocated slots
+  // and changed versions, given in the order the slots last changed. Free
+  // slots are only ever taken from the head of the free list, so the
+  // changed ones are dropped from the head and newly freed ones appended,
+  // keeping both free lists equal in time linear in versions.
+  void patch(std::size_t allocated, std::span<const SlotVersion> versions);
+
+  // Free slots in the order they will be recycled.
+  std::vector<GenerationalIndexType> free_list() const;
+
+  // Starts or stops recording the slots whose version changes.
+  inline void log_changes(bool enabled) { _log_changes = enabled; }
+
+  // Slots changed since log_changes(true) or clear_changes, possibly
+  // repeated.
+  inline std::span<const GenerationalIndexType> changes() const {
+    return _changes;
+  }
+
+  inline void clear_changes() { _changes.clear(); }
 
  private:
+  GenerationalIndex pop_free();
+  void append_free(GenerationalIndexType index);
+
+  inline void log_change(GenerationalIndexType index) {
+    if (_log_changes)
+      _changes.push_back(index);
+  }
+
   std::vector<AllocatorEntry> _entries;
-  std::queue<GenerationalIndexType> _free;
+  // Head of the unreserved part of the free list. Reserved slots are the
+  // ones between _free_head and _reserve_head until flushed.
+  std::atomic<GenerationalIndexType> _reserve_head{free_list_end};
+  std::atomic<std::size_t> _fresh_reserved{0};
+  GenerationalIndexType _free_head = free_list_end;
+  GenerationalIndexType _free_tail = free_list_end;
+  std::size_t _free_count = 0;
+  std::size_t _retired = 0;
+  std::uint32_t _last_generation;
+  bool _log_changes = false;
+  std::vector<GenerationalIndexType> _changes;
 };
 
-using SparseArrayIndexType = std::uint16_t;
+using SparseArrayIndexType = std::uint32_t;
 constexpr std::size_t max_generational_index_array_size{
     std::numeric_limits<SparseArrayIndexType>::max()};
 
+// Sparse index -> packed index map split into fixed size pages. Pages are only
+// allocated once an index in their range is set, so memory follows the index
+// ranges in use rather than the largest possible index.
+class PagedSparseArray {
+ public:
+  static constexpr std::size_t page_size{4096};
+  static constexpr SparseArrayIndexType tombstone{
+      std::numeric_limits<SparseArrayIndexType>::max()};
+
+  PagedSparseArray() = default;
+  PagedSparseArray(PagedSparseArray&&) = default;
+  PagedSparseArray& operator=(PagedSparseArray&&) = default;
+
+  PagedSparseArray(const PagedSparseArray& other) { *this = other; }
+
+  PagedSparseArray& operator=(const PagedSparseArray& other) {
+    if (this == &other)
+      return *this;
+    _pages.clear();
+    _pages.resize(other._pages.size());
+    for (std::size_t i = 0; i < other._pages.size(); i++) {
+      if (other._pages[i]) {
+        _pages[i] = std::make_unique<Page>(*other._pages[i]);
+      }
+    }
+    return *this;
+  }
+
+  inline bool contains(GenerationalIndexType index) const {
+    return get(index) != tombstone;
+  }
+
+  // Packed index stored for index, or tombstone when unset.
+  inline SparseArrayIndexType get(GenerationalIndexType index) const {
+    const auto page = index / page_size;
+    if (page >= _pages.size() || !_pages[page]) {
+      return tombstone;
+    }
+    return (*_pages[page])[index % page_size];
+  }
+
+  // Caller guarantees index was previously set.
+  inline SparseArrayIndexType get_unchecked(GenerationalIndexType index) const {
+    return (*_pages[index / page_size])[index % page_size];
+  }
+
+  inline void set(GenerationalIndexType index, SparseArrayIndexType value) {
+    assure_page(index / page_size)[index % page_size] = value;
+  }
+
+  inline void reset(GenerationalIndexType index) {
+    const auto page = index / page_size;
+    if (page < _pages.size() && _pages[page]) {
+      (*_pages[page])[index % page_size] = tombstone;
+    }
+  }
+
+  inline std::size_t pages() const {
+    return std::count_if(_pages.begin(), _pages.end(),
+                         [](const auto& page) { return page != nullptr; });
+  }
+
+  // Heap bytes of the page table and its pages.
+  inline std::size_t bytes() const {
+    return _pages.capacity() * sizeof(_pages[0]) + pages() * sizeof(Page);
+  }
+
+ private:
+  using Page = std::array<SparseArrayIndexType, page_size>;
+
+  Page& assure_page(std::size_t page) {
+    if (page >= _pages.size()) {
+      _pages.resize(page + 1);
+    }
+    if (!_pages[page]) {
+      _pages[page] = std::make_unique<Page>();
+      _pages[page]->fill(tombstone);
+    }
+    return *_pages[page];
+  }
+
+  std::vector<std::unique_ptr<Page>> _pages;
+};
+
+// Point in time used for change detection, advanced by the owner of the
+// arrays, e.g. once per frame.
+using Tick = std::uint32_t;
+
+// When a value was added and when it was last accessed mutably.
+struct ComponentTicks {
+  Tick added = 0;
+  Tick changed = 0;
+};
+
+// An index removed from or changed in an array at tick, see log_changes.
+struct LoggedIndex {
+  GenerationalIndex index;
+  Tick tick;
+};
+
+// Size and heap bytes of an index array.
+struct IndexArrayStats {
+  std::size_t size = 0;
+  // Packed ids, values and ticks.
+  std::size_t dense_bytes = 0;
+  // Sparse pages mapping indices to packed positions.
+  std::size_t sparse_bytes = 0;
+};
+
+// Type erased interface of the index arrays, used to drop an index from
+// arrays whose value type is not known statically.
+class IndexArrayBase {
+ public:
+  virtual ~IndexArrayBase() = default;
+
+  // Removes index if present. Returns whether it was present.
+  virtual bool erase(const GenerationalIndex& index) = 0;
+
+  // Tick stamped on values added or changed from now on, if tracked.
+  virtual void set_tick(Tick) {}
+
+  // Starts or stops recording removed and changed indices, if tracked.
+  virtual void log_changes(bool) {}
+
+  // Drops recorded removals and changes at or before tick.
+  virtual void trim_changes(Tick) {}
+
+  virtual IndexArrayStats stats() const { return {}; }
+};
+
+// Bytes of a cache line.
+constexpr std::size_t cache_line_size{64};
+
+// Allocates from a memory_resource like std::pmr::polymorphic_allocator,
+// but aligned to whole cache lines, so threads can split the array on line
+// boundaries.
+template <class T>
+class CacheAlignedAllocator {
+ public:
+  using value_type = T;
+
+  CacheAlignedAllocator(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : _resource(resource) {}
+
+  template <class U>
+  CacheAlignedAllocator(const CacheAlignedAllocator<U>& other)
+      : _resource(other.resource()) {}
+
+  T* allocate(std::size_t count) {
+    if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T*>(_resource->allocate(count * sizeof(T), alignment));
+  }
+
+  void deallocate(T* pointer, std::size_t count) {
+    _resource->deallocate(pointer, count * sizeof(T), alignment);
+  }
+
+  // Copies use the default resource, as with polymorphic_allocator.
+  CacheAlignedAllocator select_on_container_copy_construction() const {
+    return {};
+  }
+
+  inline std::pmr::memory_resource* resource() const { return _resource; }
+
+  template <class U>
+  friend bool operator==(const CacheAlignedAllocator& a,
+                         const CacheAlignedAllocator<U>& b) {
+    return *a.resource() == *b.resource();
+  }
+
+ private:
+  static constexpr std::size_t alignment{
+      std::max(alignof(T), cache_line_size)};
+
+  std::pmr::memory_resource* _resource;
+};
+
+template <class T>
+using CacheAlignedVector = std::vector<T, CacheAlignedAllocator<T>>;
+
 template <typename T>
-class GenerationalIndexArray {
+class GenerationalIndexArray : public IndexArrayBase {
  public:
-  GenerationalIndexArray() = default;
+  using value_type = T;
+
+  // The packed arrays allocate from resource.
+  explicit GenerationalIndexArray(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : _data_ids(resource),
+        _data(resource),
+        _ticks(resource),
+        _removals(resource),
+        _changes(resource) {}
   virtual ~GenerationalIndexArray() = default;
 
   template <typename... Args>
   bool emplace(const GenerationalIndex& index, Args&&... args) {
-    if (contains(index))
+    // the slot may still hold an older generation of this index
+    if (_indices.contains(index.index()))
       return false;
-    // not live yet
-    _index_live[index.index()] = true;
+    if (_data.size() >= max_generational_index_array_size) {
+      throw std::length_error("GenerationalIndexArray is full.");
+    }
     // add to end of packed array
     _data_ids.push_back(index);
     _data.emplace_back(std::forward<Args>(args)...);
+    _ticks.push_back({_tick, _tick});
+    log_change(index);
     // map end of packedarray to this index
-    _indices[index.index()] = _data.size() - 1;
+    _indices.set(index.index(), _data.size() - 1);
     return true;
   }
 
+  inline void reserve(std::size_t capacity) {
+    _data_ids.reserve(capacity);
+    _data.reserve(capacity);
+    _ticks.reserve(capacity);
+  }
+
+  // Emplaces make(i) for every indices[i] not already present, after
+  // reserving room for all of them. Returns the number added.
+  template <typename Generator>
+    requires std::invocable<Generator&, std::size_t>
+  std::size_t emplace_bulk(std::span<const GenerationalIndex> indices,
+                           Generator make) {
+    if (_data.size() + indices.size() > max_generational_index_array_size) {
+      throw std::length_error("GenerationalIndexArray is full.");
+    }
+    reserve(_data.size() + indices.size());
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < indices.size(); i++) {
+      const auto& index = indices[i];
+      if (_indices.contains(index.index()))
+        continue;
+      _data_ids.push_back(index);
+      _data.emplace_back(make(i));
+      _ticks.push_back({_tick, _tick});
+      log_change(index);
+      _indices.set(index.index(), _data.size() - 1);
+      added++;
+    }
+    return added;
+  }
+
+  std::size_t emplace_bulk(std::span<const GenerationalIndex> indices,
+                           std::span<const T> values) {
+    if (indices.size() != values.size()) {
+      throw std::invalid_argument("Bulk emplace needs one value per index.");
+    }
+    return emplace_bulk(indices, [&](std::size_t i) { return values[i]; });
+  }
+
+  // Replaces the contents with the packed arrays of another array, e.g.
+  // from a snapshot. ids must be unique. values is adopted without copying
+  // when it uses resource().
+  void assign(std::span<const GenerationalIndex> ids,
+              CacheAlignedVector<T> values,
+              std::span<const ComponentTicks> ticks) {
+    if (ids.size() != values.size() || ids.size() != ticks.size()) {
+      throw std::invalid_argument("Assign needs one value per index.");
+    }
+    _indices = PagedSparseArray{};
+    _data_ids.assign(ids.begin(), ids.end());
+    _data = std::move(values);
+    _ticks.assign(ticks.begin(), ticks.end());
+    for (std::size_t i = 0; i < _data_ids.size(); i++) {
+      _indices.set(_data_ids[i].index(), i);
+      log_change(_data_ids[i]);
+    }
+  }
+
+  // Removes every contained index. Large batches compact the packed arrays
+  // in a single pass that keeps the order of the remaining items.
+  std::size_t remove_bulk(std::span<const GenerationalIndex> indices) {
+    if (indices.size() * 8 < _data.size()) {
+      std::size_t removed = 0;
+      for (const auto& index : indices) {
+        if (contains(index)) {
+          remove(index);
+          removed++;
+        }
+      }
+      return removed;
+    }
+    for (const auto& index : indices) {
+      if (contains(index)) {
+        log_removal(index);
+        _indices.reset(index.index());
+      }
+    }
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < _data.size(); i++) {
+      const auto sparse_index = _data_ids[i].index();
+      if (!_indices.contains(sparse_index))
+        continue;
+      if (kept != i) {
+        _data[kept] = std::move(_data[i]);
+        _data_ids[kept] = _data_ids[i];
+        _ticks[kept] = _ticks[i];
+        _indices.set(sparse_index, kept);
+      }
+      kept++;
+    }
+    const std::size_t removed = _data.size() - kept;
+    _data.erase(_data.begin() + kept, _data.end());
+    _data_ids.erase(_data_ids.begin() + kept, _data_ids.end());
+    _ticks.erase(_ticks.begin() + kept, _ticks.end());
+    return removed;
+  }
+
   const T& get(const GenerationalIndex& index) const {
     auto packed_array_index = check_and_translate_index(index);
     return _data[packed_array_index];
   }
 
+  // Mutable access marks the value as changed.
   T& get(const GenerationalIndex& index) {
-    return const_cast<T&>(std::as_const(*this).get(index));
+    auto packed_array_index = check_and_translate_index(index);
+    touch_at(packed_array_index);
+    return _data[packed_array_index];
+  }
+
+  // Caller guarantees the array contains index.
+  inline const T& get_unchecked(const GenerationalIndex& index) const {
+    return _data[_indices.get_unchecked(index.index())];
+  }
+
+  inline T& get_unchecked(const GenerationalIndex& index) {
+    return _data[_indices.get_unchecked(index.index())];
   }
 
   inline bool contains(const GenerationalIndex& index) const {
-    return _index_live[index.index()];
+    auto packed_array_index = _indices.get(index.index());
+    return packed_array_index != PagedSparseArray::tombstone &&
+           _data_ids[packed_array_index].generation() == index.generation();
+  }
+
+  // index's value, or nullptr when absent. One sparse lookup.
+  inline const T* find(const GenerationalIndex& index) const {
+    auto packed_array_index = _indices.get(index.index());
+    if (packed_array_index == PagedSparseArray::tombstone ||
+        _data_ids[packed_array_index].generation() != index.generation())
+      return nullptr;
+    return &_data[packed_array_index];
+  }
+
+  inline T* find(const GenerationalIndex& index) {
+    return const_cast<T*>(std::as_const(*this).find(index));
   }
 
   void remove(const GenerationalIndex& index) {
     auto remove_id = check_and_translate_index(index);
-    // if removing only item or last item in data
-    if (remove_id == _data_ids.size() - 1) {
-      _index_live[index.index()] = false;
-    } else {
-      auto swap_id = _data.size() - 1;
-      auto swap_index = _data_ids[swap_id].index();
-      _indices[swap_index] = index.index();
+    log_removal(index);
+    auto swap_id = _data.size() - 1;
+    // if removing only item or last item in data there is nothing to move
+    if (remove_id != swap_id) {
+      // the last item takes the removed item's packed slot
+      _indices.set(_data_ids[swap_id].index(), remove_id);
       std::swap(_data[remove_id], _data[swap_id]);
       std::swap(_data_ids[remove_id], _data_ids[swap_id]);
-
-      // invalidate the indicies entry, mapping index to data
-      _index_live[index.index()] = false;
+      _ticks[remove_id] = _ticks[swap_id];
     }
+    // invalidate the indicies entry, mapping index to data
+    _indices.reset(index.index());
     // Remove last item, it is the index to be removed
     _data_ids.pop_back();
     _data.pop_back();
+    _ticks.pop_back();
+  }
+
+  bool erase(const GenerationalIndex& index) override {
+    if (!contains(index))
+      return false;
+    remove(index);
+    return true;
+  }
+
+  inline const std::pmr::vector<GenerationalIndex>& indices() const {
+    return _data_ids;
+  }
+
+  // Packed values, in the same order as indices().
+  inline const CacheAlignedVector<T>& values() const { return _data; }
+
+  inline CacheAlignedVector<T>& values() { return _data; }
+
+  // Packed ticks, in the same order as indices().
+  inline const CacheAlignedVector<ComponentTicks>& ticks() const {
+    return _ticks;
+  }
+
+  // Packed position of index, or tombstone when absent.
+  inline SparseArrayIndexType position(const GenerationalIndex& index) const {
+    auto packed_array_index = _indices.get(index.index());
+    if (packed_array_index == PagedSparseArray::tombstone ||
+        _data_ids[packed_array_index].generation() != index.generation())
+      return PagedSparseArray::tombstone;
+    return packed_array_index;
+  }
+
+  // Caller guarantees the array contains index.
+  inline SparseArrayIndexType position_unchecked(
+      const GenerationalIndex& index) const {
+    return _indices.get_unchecked(index.index());
+  }
+
+  // The stored index, of whichever generation, at the sparse index, or
+  // nullptr when there is none.
+  inline const GenerationalIndex* stored_index(
+      GenerationalIndexType index) const {
+    const auto packed_array_index = _indices.get(index);
+    return packed_array_index != PagedSparseArray::tombstone
+               ? &_data_ids[packed_array_index]
+               : nullptr;
+  }
+
+  // Swaps the values stored at two packed positions, used to keep pools
+  // co-sorted, see Group.
+  void swap_positions(std::size_t a, std::size_t b) {
+    if (a == b)
+      return;
+    std::swap(_data[a], _data[b]);
+    std::swap(_data_ids[a], _data_ids[b]);
+    std::swap(_ticks[a], _ticks[b]);
+    _indices.set(_data_ids[a].index(), a);
+    _indices.set(_data_ids[b].index(), b);
+  }
+
+  // Marks the value at packed position as changed. Logged at most once
+  // per tick, the first time it is touched.
+  inline void touch_at(std::size_t position) {
+    if (stamp_at(position))
+      log_change(_data_ids[position]);
+  }
+
+  // touch_at without the logging, so threads may stamp distinct positions
+  // at once. True when the value wasn't changed yet this tick, and the
+  // caller must pass its index to log_stamped later.
+  inline bool stamp_at(std::size_t position) {
+    auto& changed = _ticks[position].changed;
+    if (changed == _tick)
+      return false;
+    changed = _tick;
+    return true;
+  }
+
+  // Logs indices stamped through stamp_at, when logging changes.
+  void log_stamped(std::span<const GenerationalIndex> indices) {
+    for (const auto& index : indices) {
+      log_change(index);
+    }
+  }
+
+  inline bool logs_changes() const { return _log_changes; }
+
+  inline Tick tick() const { return _tick; }
+
+  void set_tick(Tick tick) override { _tick = tick; }
+
+  // Overwrites the ticks at packed position, e.g. when mirroring another
+  // array.
+  inline void set_ticks_at(std::size_t position, const ComponentTicks& ticks) {
+    _ticks[position] = ticks;
+  }
+
+  // Values already changed in the current tick are logged again from the
+  // next one.
+  void log_changes(bool enabled) override { _log_changes = enabled; }
+
+  // Removals recorded since log_changes(true), oldest first.
+  inline const std::pmr::vector<LoggedIndex>& removals() const {
+    return _removals;
+  }
+
+  // Indices added or changed since log_changes(true), oldest first. An
+  // index is logged once per tick it changed in, and may have been removed
+  // since.
+  inline const std::pmr::vector<LoggedIndex>& changes() const {
+    return _changes;
+  }
+
+  void trim_changes(Tick tick) override {
+    const auto at_or_before = [&](const LoggedIndex& logged) {
+      return logged.tick <= tick;
+    };
+    std::erase_if(_removals, at_or_before);
+    std::erase_if(_changes, at_or_before);
   }
 
-  const std::vector<GenerationalIndex>& indices() { return _data_ids; }
+  inline std::size_t size() const { return _data.size(); }
+
+  inline bool empty() const { return _data.empty(); }
+
+  inline std::pmr::memory_resource* resource() const {
+    return _data.get_allocator().resource();
+  }
+
+  IndexArrayStats stats() const override {
+    return {_data.size(),
+            _data_ids.capacity() * sizeof(GenerationalIndex) +
+                _data.capacity() * sizeof(T) +
+                _ticks.capacity() * sizeof(ComponentTicks) +
+                (_removals.capacity() + _changes.capacity()) *
+                    sizeof(LoggedIndex),
+            _indices.bytes()};
+  }
 
  private:
   SparseArrayIndexType check_and_translate_index(
       const GenerationalIndex& index) const {
-    if (!contains(index)) {
+    SparseArrayIndexType packed_array_index{_indices.get(index.index())};
+    if (packed_array_index == PagedSparseArray::tombstone) {
       throw std::out_of_range(fmt::format(
           "GenerationalIndexArray accessed non-existent index: {} {}",
           index.index(), index.generation()));
     }
-    SparseArrayIndexType packed_array_index{_indices[index.index()]};
     auto& stored_index = _data_ids[packed_array_index];
     if (stored_index.index() != index.index()) {
       throw std::runtime_error("Stored id does not match requested id.");
@@ -159,10 +741,30 @@ class GenerationalIndexArray {
     return packed_array_index;
   }
 
-  std::array<SparseArrayIndexType, max_generational_index_array_size> _indices;
-  std::bitset<max_generational_index_array_size> _index_live;
-  std::vector<GenerationalIndex> _data_ids;
-  std::vector<T> _data;
+  inline void log_removal(const GenerationalIndex& index) {
+    if (_log_changes)
+      _removals.push_back({index, _tick});
+  }
+
+  inline void log_change(const GenerationalIndex& index) {
+    if (_log_changes)
+      _changes.push_back({index, _tick});
+  }
+
+  PagedSparseArray _indices;
+  std::pmr::vector<GenerationalIndex> _data_ids;
+  // Cache line aligned, see parallel_grain_step.
+  CacheAlignedVector<T> _data;
+  CacheAlignedVector<ComponentTicks> _ticks;
+  Tick _tick = 0;
+  bool _log_changes = false;
+  std::pmr::vector<LoggedIndex> _removals;
+  std::pmr::vector<LoggedIndex> _changes;
 };
 };  // namespace engine
+
+template <unsigned IndexBits, unsigned GenerationBits>
+struct std::hash<engine::BasicGenerationalIndex<IndexBits, GenerationBits>>
+    : engine::BasicGenerationalIndex<IndexBits, GenerationBits>::HashFunction {
+};
 #endif
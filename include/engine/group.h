@@ -0,0 +1,108 @@
+#ifndef ENGINE_GROUP_H
+#define ENGINE_GROUP_H
+
+#include <engine/generational_index.h>
+#include <engine/query.h>
+#include <engine/soa.h>
+#include <engine/system_traits.h>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <utility>
+
+namespace engine {
+
+// Number of entities a group keeps at the front of its arrays.
+class GroupBase : public QueryBase {
+ public:
+  inline std::size_t size() const { return _size; }
+
+  inline bool empty() const { return _size == 0; }
+
+ protected:
+  std::size_t _size = 0;
+};
+
+// Owns ComponentType's arrays and keeps them co-sorted: the indices present
+// in every array occupy the packed positions [0, size()) of each, in the same
+// order. Iterating them is a linear scan over every array with no lookups.
+// on_add/on_remove swap indices in and out of that prefix, so the group
+// must see every structural change, see ComponentRegistry::group.
+template <class... ComponentType>
+class Group : public GroupBase {
+  static_assert(sizeof...(ComponentType) > 1,
+                "A group co-sorts at least two component types.");
+  static_assert(!(soa_component<ComponentType> || ...),
+                "soa_layout components can't be grouped.");
+
+ public:
+  explicit Group(GenerationalIndexArray<ComponentType>&... arrays)
+      : _arrays(arrays...) {
+    const auto indices = std::get<0>(_arrays).indices();
+    for (const auto& index : indices) {
+      on_add(index);
+    }
+  }
+
+  void on_add(GenerationalIndex index) override {
+    if (contains(index))
+      return;
+    if (!(std::get<GenerationalIndexArray<ComponentType>&>(_arrays).contains(
+              index) &&
+          ...))
+      return;
+    for_arrays([&](auto& array) {
+      array.swap_positions(array.position_unchecked(index), _size);
+    });
+    _size++;
+  }
+
+  void on_remove(GenerationalIndex index) override {
+    if (!contains(index))
+      return;
+    _size--;
+    for_arrays([&](auto& array) {
+      array.swap_positions(array.position_unchecked(index), _size);
+    });
+  }
+
+  inline bool contains(const GenerationalIndex& index) const {
+    return std::get<0>(_arrays).position(index) < _size;
+  }
+
+  inline std::span<const GenerationalIndex> entities() const {
+    return {std::get<0>(_arrays).indices().data(), _size};
+  }
+
+  // The group's prefix of T's packed values, in entities() order.
+  template <class T>
+  inline std::span<T> values() {
+    return {std::get<GenerationalIndexArray<T>&>(_arrays).values().data(),
+            _size};
+  }
+
+  // Calls f(components...) for every entity of the group. Components f
+  // takes by non-const reference are marked as changed.
+  template <typename Func>
+  void each(Func f) {
+    constexpr auto writes =
+        detail::written_components<Func, sizeof...(ComponentType)>();
+    auto data = std::make_tuple(values<ComponentType>().data()...);
+    for (std::size_t i = 0; i < _size; i++) {
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((writes[I] ? std::get<I>(_arrays).touch_at(i) : void()), ...);
+        f(std::get<I>(data)[i]...);
+      }(std::index_sequence_for<ComponentType...>{});
+    }
+  }
+
+ private:
+  template <typename Func>
+  void for_arrays(Func f) {
+    std::apply([&](auto&... arrays) { (f(arrays), ...); }, _arrays);
+  }
+
+  std::tuple<GenerationalIndexArray<ComponentType>&...> _arrays;
+};
+};  // namespace engine
+#endif
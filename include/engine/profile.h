@@ -0,0 +1,205 @@
+#ifndef ENGINE_PROFILE_H
+#define ENGINE_PROFILE_H
+
+#include <engine/generational_index.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Instrumentation is compiled in when ENGINE_PROFILING is 1, see the
+// ELDER_PROFILING CMake option. Otherwise the ENGINE_PROFILE_* macros expand
+// to nothing and QueryCounter is empty.
+#ifndef ENGINE_PROFILING
+#define ENGINE_PROFILING 0
+#endif
+
+namespace engine {
+
+// Structural changes, counted per frame.
+enum class ProfileCounter : std::size_t {
+  entities_created,
+  entities_destroyed,
+  components_added,
+  components_removed,
+};
+
+constexpr std::size_t profile_counter_count{4};
+
+// type's name, demangled where the compiler supports it.
+std::string type_name(const std::type_info& type);
+
+// A component pool's stats, see ComponentRegistry::pool_stats.
+struct PoolStats {
+  std::string name;
+  IndexArrayStats array;
+};
+
+// Collects timed zones, visited entities per query, pool sizes and
+// structural change counts, frame by frame. Exports them as a Chrome trace
+// or a plain text summary. Thread safe.
+class Profiler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Trace events past this many are dropped, the summary still counts them.
+  static constexpr std::size_t default_max_events{1 << 20};
+
+  explicit Profiler(std::size_t max_events = default_max_events);
+
+  void record_zone(std::string_view name, Clock::time_point start,
+                   Clock::time_point end);
+
+  inline void count(ProfileCounter counter, std::uint64_t n) {
+    _counters[static_cast<std::size_t>(counter)].fetch_add(
+        n, std::memory_order_relaxed);
+  }
+
+  void record_query(std::string_view name, std::size_t entities);
+
+  // Latest pool stats, replacing the previous ones.
+  void record_pools(std::vector<PoolStats> pools);
+
+  // Closes the current frame, adding its structural changes, query sizes
+  // and pool stats to the trace as counters.
+  void end_frame();
+
+  void clear();
+
+  // Chrome trace event JSON, for chrome://tracing or Perfetto.
+  void write_chrome_trace(std::ostream& out) const;
+
+  // Per zone timings, query sizes, pool memory and structural changes.
+  void write_stats(std::ostream& out) const;
+
+  inline std::size_t frames() const {
+    std::lock_guard lock{_mutex};
+    return _frames;
+  }
+
+  inline std::size_t dropped() const {
+    std::lock_guard lock{_mutex};
+    return _dropped;
+  }
+
+ private:
+  struct Event {
+    // 'X' for a zone, 'C' for counters.
+    char phase;
+    std::string name;
+    std::uint64_t start_ns;
+    std::uint64_t duration_ns;
+    std::uint32_t thread;
+    std::vector<std::pair<std::string, std::uint64_t>> counters;
+  };
+
+  struct ZoneStats {
+    std::uint64_t calls = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+  };
+
+  struct QueryStats {
+    std::uint64_t calls = 0;
+    std::uint64_t entities = 0;
+    std::uint64_t frame_entities = 0;
+  };
+
+  std::uint64_t since_start(Clock::time_point time) const;
+  void add_event(Event event);
+
+  Clock::time_point _start;
+  std::size_t _max_events;
+  mutable std::mutex _mutex;
+  std::vector<Event> _events;
+  std::size_t _dropped = 0;
+  std::size_t _frames = 0;
+  std::map<std::string, ZoneStats, std::less<>> _zones;
+  std::map<std::string, QueryStats, std::less<>> _queries;
+  std::vector<PoolStats> _pools;
+  std::array<std::atomic<std::uint64_t>, profile_counter_count> _counters{};
+  std::array<std::uint64_t, profile_counter_count> _last_frame{};
+  std::array<std::uint64_t, profile_counter_count> _totals{};
+};
+
+// Process wide profiler the ENGINE_PROFILE_* macros record to.
+Profiler& profiler();
+
+// Records the time until destruction as a zone. name must outlive it.
+class ProfileZone {
+ public:
+  explicit ProfileZone(std::string_view name,
+                       Profiler& profiler = engine::profiler())
+      : _profiler(profiler), _name(name), _start(Profiler::Clock::now()) {}
+
+  ~ProfileZone() {
+    _profiler.record_zone(_name, _start, Profiler::Clock::now());
+  }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+ private:
+  Profiler& _profiler;
+  std::string_view _name;
+  Profiler::Clock::time_point _start;
+};
+
+// Counts the entities a query over ...ComponentType visits and records them
+// when destroyed. Does nothing without ENGINE_PROFILING.
+template <class... ComponentType>
+class QueryCounter {
+ public:
+#if ENGINE_PROFILING
+  ~QueryCounter() { profiler().record_query(name(), _visited); }
+
+  inline void visit() { _visited++; }
+
+ private:
+  static const std::string& name() {
+    static const std::string joined = [] {
+      std::string result;
+      ((result += (result.empty() ? "" : ", ") +
+                  type_name(typeid(ComponentType))),
+       ...);
+      return result;
+    }();
+    return joined;
+  }
+
+  std::size_t _visited = 0;
+#else
+  inline void visit() {}
+#endif
+};
+};  // namespace engine
+
+#define ENGINE_PROFILE_CONCAT_(a, b) a##b
+#define ENGINE_PROFILE_CONCAT(a, b) ENGINE_PROFILE_CONCAT_(a, b)
+
+#if ENGINE_PROFILING
+// Times the rest of the enclosing scope as a zone called name.
+#define ENGINE_PROFILE_ZONE(name)                                  \
+  ::engine::ProfileZone ENGINE_PROFILE_CONCAT(engine_profile_zone_, \
+                                              __LINE__) {          \
+    name                                                           \
+  }
+// Adds n to the frame's ProfileCounter::counter.
+#define ENGINE_PROFILE_COUNT(counter, n) \
+  ::engine::profiler().count(::engine::ProfileCounter::counter, n)
+#define ENGINE_PROFILE_FRAME() ::engine::profiler().end_frame()
+#else
+#define ENGINE_PROFILE_ZONE(name) static_cast<void>(0)
+#define ENGINE_PROFILE_COUNT(counter, n) static_cast<void>(0)
+#define ENGINE_PROFILE_FRAME() static_cast<void>(0)
+#endif
+#endif
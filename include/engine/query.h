@@ -0,0 +1,102 @@
+#ifndef ENGINE_QUERY_H
+#define ENGINE_QUERY_H
+
+#include <engine/generational_index.h>
+#include <engine/system_traits.h>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// Receives structural changes for the component types a query watches.
+class QueryBase {
+ public:
+  virtual ~QueryBase() = default;
+
+  // Called after index gained one of the watched components. index is taken
+  // by value, observers may move the pool entry it was read from.
+  virtual void on_add(GenerationalIndex index) = 0;
+  // Called before index loses one of the watched components.
+  virtual void on_remove(GenerationalIndex index) = 0;
+};
+
+// Persistent set of the indices present in every one of ComponentType's
+// arrays. Kept up to date through on_add/on_remove, so iterating it does no
+// intersection or allocation.
+template <class... ComponentType>
+class Query : public QueryBase {
+ public:
+  explicit Query(GenerationalIndexArray<ComponentType>&... arrays)
+      : _arrays(arrays...) {
+    auto& first = std::get<0>(_arrays);
+    for (const auto& index : first.indices()) {
+      on_add(index);
+    }
+  }
+
+  void on_add(GenerationalIndex index) override {
+    if (_positions.contains(index.index()))
+      return;
+    if (!(std::get<GenerationalIndexArray<ComponentType>&>(_arrays).contains(
+              index) &&
+          ...))
+      return;
+    _entities.push_back(index);
+    _positions.set(index.index(), _entities.size() - 1);
+  }
+
+  void on_remove(GenerationalIndex index) override {
+    if (!_positions.contains(index.index()))
+      return;
+    auto remove_id = _positions.get_unchecked(index.index());
+    auto swap_id = _entities.size() - 1;
+    if (remove_id != swap_id) {
+      _positions.set(_entities[swap_id].index(), remove_id);
+      _entities[remove_id] = _entities[swap_id];
+    }
+    _positions.reset(index.index());
+    _entities.pop_back();
+  }
+
+  inline const std::vector<GenerationalIndex>& entities() const {
+    return _entities;
+  }
+
+  inline std::size_t size() const { return _entities.size(); }
+
+  inline bool empty() const { return _entities.empty(); }
+
+  // Calls f(components...) for every entity of the query. Components f
+  // takes by non-const reference are marked as changed.
+  template <typename Func>
+  void each(Func f) {
+    constexpr auto writes =
+        detail::written_components<Func, sizeof...(ComponentType)>();
+    for (const auto& index : _entities) {
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        f(component<writes[I]>(std::get<I>(_arrays), index)...);
+      }(std::index_sequence_for<ComponentType...>{});
+    }
+  }
+
+ private:
+  template <bool Write, class T>
+  static T& component(GenerationalIndexArray<T>& array,
+                      const GenerationalIndex& index) {
+    if constexpr (Write) {
+      const auto position = array.position_unchecked(index);
+      array.touch_at(position);
+      return array.values()[position];
+    } else {
+      return array.get_unchecked(index);
+    }
+  }
+
+  std::tuple<GenerationalIndexArray<ComponentType>&...> _arrays;
+  std::vector<GenerationalIndex> _entities;
+  PagedSparseArray _positions;
+};
+};  // namespace engine
+#endif
@@ -0,0 +1,233 @@
+#ifndef ENGINE_SCHEDULE_H
+#define ENGINE_SCHEDULE_H
+
+#include <engine/ecs.h>
+#include <engine/thread_pool.h>
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
+
+namespace engine {
+
+namespace detail {
+// Filter among Filter... whose component is Component, or Component.
+template <class Component, class... Filter>
+struct select_filter {
+  using type = Component;
+};
+
+template <class Component, class First, class... Rest>
+struct select_filter<Component, First, Rest...> {
+  using type = std::conditional_t<
+      std::is_same_v<filtered_component_t<First>, Component>, First,
+      typename select_filter<Component, Rest...>::type>;
+};
+
+template <class RegistryType>
+concept tick_registry = requires(RegistryType& registry) {
+  { registry.advance_tick() } -> std::same_as<Tick>;
+};
+};  // namespace detail
+
+// Component types a system reads and writes, kept sorted.
+struct SystemAccess {
+  std::vector<std::type_index> reads;
+  std::vector<std::type_index> writes;
+
+  bool conflicts(const SystemAccess& other) const;
+};
+
+// Runs systems in waves. Systems in a wave have no conflicting component
+// access and run concurrently on a thread pool. A system waits for every
+// earlier added system it conflicts with, and for explicit order()
+// constraints, so results match running them one by one in add order.
+//
+// With a registry that has ticks, the tick advances once at the end of
+// every run, so a run is one tick. Added/Changed filters match what changed
+// since the tick the system last ran in, excluding its own changes and
+// those of systems that ran after it in that tick: add readers after the
+// writers they react to.
+template <class RegistryType = ComponentRegistry>
+class Schedule {
+ public:
+  using SystemId = std::size_t;
+
+  explicit Schedule(ThreadPool& pool = default_thread_pool()) : _pool(pool) {}
+
+  // Adds f to run as foreach<Components...>(registry, f), where the
+  // components and their access are taken from f's parameter list. Filter
+  // replaces its component, e.g. add_system<Changed<Board>>(render).
+  template <class... Filter, typename Func>
+  SystemId add_system(Func f) {
+    using Arguments = typename detail::system_traits<Func>::arguments;
+    return add_system_with<Filter...>(f, static_cast<Arguments*>(nullptr));
+  }
+
+  // Run after only once before has finished.
+  void order(SystemId before, SystemId after) {
+    if (before >= _systems.size() || after >= _systems.size()) {
+      throw std::out_of_range("Schedule has no such system.");
+    }
+    _systems[after].dependencies.push_back(before);
+    _waves.clear();
+  }
+
+  // Name shown in profiles, "system <id>" unless set.
+  inline const std::string& name(SystemId system) const {
+    return _systems.at(system).name;
+  }
+
+  inline void set_name(SystemId system, std::string name) {
+    _systems.at(system).name = std::move(name);
+  }
+
+  inline const SystemAccess& access(SystemId system) const {
+    return _systems.at(system).access;
+  }
+
+  inline std::size_t size() const { return _systems.size(); }
+
+  const std::vector<std::vector<SystemId>>& waves() {
+    if (_waves.empty() && !_systems.empty()) {
+      build_waves();
+    }
+    return _waves;
+  }
+
+  // With ENGINE_PROFILING, each system is timed as a zone named after it
+  // and the run ends a profiler frame.
+  void run(RegistryType& registry) {
+    ENGINE_PROFILE_ZONE("Schedule::run");
+    for (const auto& wave : waves()) {
+      if (wave.size() == 1) {
+        run_system(_systems[wave.front()], registry);
+      } else {
+        _pool.parallel_for(wave.size(), [&](std::size_t i) {
+          run_system(_systems[wave[i]], registry);
+        });
+      }
+    }
+    if constexpr (detail::tick_registry<RegistryType>) {
+      registry.advance_tick();
+    }
+#if ENGINE_PROFILING
+    if constexpr (requires { registry.pool_stats(); }) {
+      profiler().record_pools(registry.pool_stats());
+    }
+#endif
+    ENGINE_PROFILE_FRAME();
+  }
+
+ private:
+  struct System {
+    // Runs the system, Added/Changed filters match changes after since.
+    std::function<void(RegistryType&, Tick since)> run;
+    SystemAccess access;
+    std::vector<SystemId> dependencies;
+    Tick last_run = 0;
+    std::string name;
+  };
+
+  static void run_system(System& system, RegistryType& registry) {
+    ENGINE_PROFILE_ZONE(system.name);
+    if constexpr (detail::tick_registry<RegistryType>) {
+      system.run(registry, system.last_run);
+      system.last_run = registry.tick();
+    } else {
+      system.run(registry, 0);
+    }
+  }
+
+  template <class... Filter, typename Func, typename... Args>
+  SystemId add_system_with(Func f, std::tuple<Args...>*) {
+    System system;
+    if constexpr (sizeof...(Filter) == 0) {
+      system.run = [f](RegistryType& registry, Tick) {
+        foreach
+          <std::remove_cvref_t<Args>...>(registry, f);
+      };
+    } else {
+      system.run = [f](RegistryType& registry, Tick since) {
+        foreach
+          <typename detail::select_filter<std::remove_cvref_t<Args>,
+                                          Filter...>::type...>(registry, f,
+                                                               since);
+      };
+    }
+    (
+        [&] {
+          auto& list = detail::writes_argument<Args> ? system.access.writes
+                                                     : system.access.reads;
+          list.emplace_back(typeid(std::remove_cvref_t<Args>));
+        }(),
+        ...);
+    std::sort(system.access.reads.begin(), system.access.reads.end());
+    std::sort(system.access.writes.begin(), system.access.writes.end());
+    system.name = "system " + std::to_string(_systems.size());
+    _systems.push_back(std::move(system));
+    _waves.clear();
+    return _systems.size() - 1;
+  }
+
+  void build_waves() {
+    const std::size_t count = _systems.size();
+    std::vector<std::vector<SystemId>> dependencies(count);
+    for (SystemId id = 0; id < count; id++) {
+      dependencies[id] = _systems[id].dependencies;
+      for (SystemId earlier = 0; earlier < id; earlier++) {
+        if (_systems[id].access.conflicts(_systems[earlier].access)) {
+          dependencies[id].push_back(earlier);
+        }
+      }
+    }
+    // Kahn's algorithm, a system's wave is one past its latest dependency
+    std::vector<std::size_t> wave_of(count, 0);
+    std::vector<std::size_t> remaining(count);
+    std::vector<std::vector<SystemId>> dependents(count);
+    std::vector<SystemId> ready;
+    for (SystemId id = 0; id < count; id++) {
+      remaining[id] = dependencies[id].size();
+      for (auto dependency : dependencies[id]) {
+        dependents[dependency].push_back(id);
+      }
+      if (remaining[id] == 0) {
+        ready.push_back(id);
+      }
+    }
+    std::size_t visited = 0;
+    while (!ready.empty()) {
+      auto id = ready.back();
+      ready.pop_back();
+      visited++;
+      if (wave_of[id] >= _waves.size()) {
+        _waves.resize(wave_of[id] + 1);
+      }
+      _waves[wave_of[id]].push_back(id);
+      for (auto dependent : dependents[id]) {
+        wave_of[dependent] = std::max(wave_of[dependent], wave_of[id] + 1);
+        if (--remaining[dependent] == 0) {
+          ready.push_back(dependent);
+        }
+      }
+    }
+    if (visited != count) {
+      _waves.clear();
+      throw std::runtime_error("Schedule system ordering has a cycle.");
+    }
+    for (auto& wave : _waves) {
+      std::sort(wave.begin(), wave.end());
+    }
+  }
+
+  ThreadPool& _pool;
+  std::vector<System> _systems;
+  std::vector<std::vector<SystemId>> _waves;
+};
+};  // namespace engine
+#endif
@@ -0,0 +1,303 @@
+#ifndef ENGINE_SNAPSHOT_H
+#define ENGINE_SNAPSHOT_H
+
+#include <engine/ecs.h>
+#include <engine/generational_index.h>
+#include <engine/type_map.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+
+constexpr std::uint32_t snapshot_version{1};
+// Every section starts at a multiple of this, so arrays can be used in place.
+constexpr std::size_t snapshot_alignment{64};
+
+enum class SnapshotSectionKind : std::uint32_t {
+  allocator = 1,
+  ids = 2,
+  values = 3,
+  ticks = 4,
+  // Values written through snapshot_traits, count is the number of values.
+  serialized = 5,
+};
+
+struct SnapshotHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t sections;
+  std::uint64_t tick;
+};
+
+struct SnapshotSection {
+  // Component the section belongs to, see snapshot_key.
+  std::uint64_t key;
+  SnapshotSectionKind kind;
+  std::uint32_t element_size;
+  std::uint64_t count;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+// Appends values to a serialized section.
+class SnapshotOutput {
+ public:
+  template <class T>
+    requires std::is_trivially_copyable_v<T>
+  void write(const T& value) {
+    write_bytes(&value, sizeof(T));
+  }
+
+  inline void write(std::string_view text) {
+    write<std::uint64_t>(text.size());
+    write_bytes(text.data(), text.size());
+  }
+
+  inline void write_bytes(const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const std::byte*>(data);
+    _bytes.insert(_bytes.end(), bytes, bytes + size);
+  }
+
+  inline std::vector<std::byte>& bytes() { return _bytes; }
+
+ private:
+  std::vector<std::byte> _bytes;
+};
+
+// Reads back what SnapshotOutput wrote.
+class SnapshotInput {
+ public:
+  explicit SnapshotInput(std::span<const std::byte> bytes) : _bytes(bytes) {}
+
+  template <class T>
+    requires std::is_trivially_copyable_v<T>
+  T read() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+    return value;
+  }
+
+  inline std::string read_string() {
+    const auto size = read<std::uint64_t>();
+    const auto bytes = take(size);
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+  }
+
+ private:
+  inline std::span<const std::byte> take(std::size_t size) {
+    if (size > _bytes.size()) {
+      throw std::runtime_error("Snapshot section is truncated.");
+    }
+    auto bytes = _bytes.first(size);
+    _bytes = _bytes.subspan(size);
+    return bytes;
+  }
+
+  std::span<const std::byte> _bytes;
+};
+
+// Specialize with
+//   static void save(SnapshotOutput&, const T&);
+//   static T load(SnapshotInput&);
+// for components that are not trivially copyable, e.g. ones owning strings.
+template <class T>
+struct snapshot_traits {};
+
+template <class T>
+concept snapshot_serializable = requires(SnapshotOutput& out,
+                                         SnapshotInput& in, const T& value) {
+  snapshot_traits<T>::save(out, value);
+  { snapshot_traits<T>::load(in) } -> std::same_as<T>;
+};
+
+// Components without snapshot_traits are stored as raw arrays.
+template <class T>
+concept snapshot_raw =
+    std::is_trivially_copyable_v<T> && !snapshot_serializable<T>;
+
+// Identifies T's sections, see stable_type_id.
+template <class T>
+constexpr std::uint64_t snapshot_key() {
+  return stable_type_id<T>();
+}
+
+// Collects sections and writes them to a file. Sections borrow their bytes,
+// which must stay alive until write.
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(Tick tick = 0) : _tick(tick) {}
+
+  template <class T>
+  void add(std::uint64_t key, SnapshotSectionKind kind,
+           std::span<const T> values) {
+    add_bytes(key, kind, sizeof(T), values.size(), std::as_bytes(values));
+  }
+
+  inline void add_owned(std::uint64_t key, SnapshotSectionKind kind,
+                        std::size_t count, std::vector<std::byte> bytes) {
+    const auto& owned = _owned.emplace_back(std::move(bytes));
+    add_bytes(key, kind, 1, count, owned);
+  }
+
+  void write(const std::string& path) const;
+
+ private:
+  void add_bytes(std::uint64_t key, SnapshotSectionKind kind,
+                 std::size_t element_size, std::size_t count,
+                 std::span<const std::byte> bytes);
+
+  Tick _tick;
+  std::vector<SnapshotSection> _sections;
+  std::vector<std::span<const std::byte>> _bytes;
+  std::list<std::vector<std::byte>> _owned;
+};
+
+// Snapshot file mapped into memory. Sections are read in place.
+class Snapshot {
+ public:
+  explicit Snapshot(const std::string& path);
+  ~Snapshot();
+
+  Snapshot(const Snapshot&) = delete;
+  Snapshot& operator=(const Snapshot&) = delete;
+
+  inline Tick tick() const { return static_cast<Tick>(header().tick); }
+
+  // Section of key and kind, or nullptr.
+  const SnapshotSection* find(std::uint64_t key,
+                              SnapshotSectionKind kind) const;
+
+  inline std::span<const std::byte> bytes(
+      const SnapshotSection& section) const {
+    return {_data + section.offset, section.size};
+  }
+
+  // The section of key and kind as an array of T. Throws when missing or
+  // when its elements are not T sized.
+  template <class T>
+  std::span<const T> array(std::uint64_t key, SnapshotSectionKind kind) const {
+    const auto* section = find(key, kind);
+    if (section == nullptr) {
+      throw std::runtime_error("Snapshot section is missing.");
+    }
+    if (section->element_size != sizeof(T)) {
+      throw std::runtime_error("Snapshot section has a different layout.");
+    }
+    return {reinterpret_cast<const T*>(_data + section->offset),
+            section->count};
+  }
+
+ private:
+  inline const SnapshotHeader& header() const {
+    return *reinterpret_cast<const SnapshotHeader*>(_data);
+  }
+
+  void validate() const;
+  void close();
+
+  const std::byte* _data = nullptr;
+  std::size_t _size = 0;
+  // Whether _data is mapped, otherwise the file was read into an aligned
+  // allocation.
+  bool _mapped = false;
+};
+
+namespace detail {
+template <class ComponentType>
+void save_pool(SnapshotWriter& writer,
+               const GenerationalIndexArray<ComponentType>& pool) {
+  const auto key = snapshot_key<ComponentType>();
+  writer.add<GenerationalIndex>(key, SnapshotSectionKind::ids,
+                                pool.indices());
+  writer.add<ComponentTicks>(key, SnapshotSectionKind::ticks, pool.ticks());
+  if constexpr (snapshot_raw<ComponentType>) {
+    writer.add<ComponentType>(key, SnapshotSectionKind::values,
+                              pool.values());
+  } else {
+    static_assert(snapshot_serializable<ComponentType>,
+                  "Component needs snapshot_traits to be saved.");
+    SnapshotOutput out;
+    for (const auto& value : pool.values()) {
+      snapshot_traits<ComponentType>::save(out, value);
+    }
+    writer.add_owned(key, SnapshotSectionKind::serialized, pool.size(),
+                     std::move(out.bytes()));
+  }
+}
+
+// Fills ComponentType's pool with a copy of its sections: ids, ticks and
+// raw values are copied once each, other values deserialized. The pool owns
+// its memory afterwards and nothing refers to the snapshot.
+template <class ComponentType>
+void copy_pool(const Snapshot& snapshot, ComponentRegistry& components) {
+  const auto key = snapshot_key<ComponentType>();
+  const auto ids = snapshot.array<GenerationalIndex>(
+      key, SnapshotSectionKind::ids);
+  const auto ticks =
+      snapshot.array<ComponentTicks>(key, SnapshotSectionKind::ticks);
+  components.register_component<ComponentType>();
+  CacheAlignedVector<ComponentType> values{
+      components.pool<ComponentType>().resource()};
+  if constexpr (snapshot_raw<ComponentType>) {
+    // a single copy, a vector can't adopt memory it didn't allocate
+    const auto raw =
+        snapshot.array<ComponentType>(key, SnapshotSectionKind::values);
+    values.assign(raw.begin(), raw.end());
+  } else {
+    const auto* section = snapshot.find(key, SnapshotSectionKind::serialized);
+    if (section == nullptr) {
+      throw std::runtime_error("Snapshot section is missing.");
+    }
+    SnapshotInput in{snapshot.bytes(*section)};
+    values.reserve(section->count);
+    for (std::size_t i = 0; i < section->count; i++) {
+      values.push_back(snapshot_traits<ComponentType>::load(in));
+    }
+  }
+  components.assign_pool<ComponentType>(ids, std::move(values), ticks);
+}
+
+constexpr std::uint64_t snapshot_allocator_key{0};
+};  // namespace detail
+
+// Writes the entity allocator and the pools of ...ComponentType.
+template <class... ComponentType>
+void save_snapshot(const std::string& path, Registry& registry) {
+  static_assert(!(tag_component<ComponentType> || ...),
+                "Tags have no pools to save.");
+  registry.entities.flush();
+  SnapshotWriter writer{registry.components.tick()};
+  writer.add<AllocatorEntry>(detail::snapshot_allocator_key,
+                             SnapshotSectionKind::allocator,
+                             registry.entities.allocator().entries());
+  (detail::save_pool<ComponentType>(
+       writer, registry.components.pool<ComponentType>()),
+   ...);
+  writer.write(path);
+}
+
+// Restores a save_snapshot into registry, whose ...ComponentType pools must
+// be empty. A single-copy load: the file is mapped and each of its arrays
+// copied into the pools in one pass, without per-component work for raw
+// types.
+template <class... ComponentType>
+void load_snapshot(const std::string& path, Registry& registry) {
+  static_assert(!(tag_component<ComponentType> || ...),
+                "Tags have no pools to load.");
+  const Snapshot snapshot{path};
+  registry.entities.allocator().assign(snapshot.array<AllocatorEntry>(
+      detail::snapshot_allocator_key, SnapshotSectionKind::allocator));
+  (detail::copy_pool<ComponentType>(snapshot, registry.components), ...);
+  registry.components.set_tick(snapshot.tick());
+}
+};  // namespace engine
+#endif
@@ -0,0 +1,453 @@
+#ifndef ENGINE_SOA_H
+#define ENGINE_SOA_H
+
+#include <engine/generational_index.h>
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// Opt in to structure of arrays storage by specializing soa_layout with the
+// component's data members, e.g.
+//   template <>
+//   struct engine::soa_layout<PositionComponent> {
+//     static constexpr auto fields =
+//         std::make_tuple(&PositionComponent::x, &PositionComponent::y);
+//   };
+// The component must be default constructible.
+template <class T>
+struct soa_layout;
+
+template <class T>
+concept soa_component = requires { soa_layout<T>::fields; };
+
+// Register width the build targets, picked from the compiler's ISA macros.
+#if defined(__AVX512F__)
+constexpr std::size_t simd_bytes{64};
+#elif defined(__AVX2__) || defined(__AVX__)
+constexpr std::size_t simd_bytes{32};
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+constexpr std::size_t simd_bytes{16};
+#else
+constexpr std::size_t simd_bytes{0};
+#endif
+
+// Values of Field per register, 1 for the scalar fallback.
+template <class Field>
+constexpr std::size_t simd_lanes{
+    simd_bytes >= sizeof(Field) ? simd_bytes / sizeof(Field) : 1};
+
+constexpr std::size_t soa_alignment{64};
+
+template <class T>
+struct AlignedAllocator {
+  using value_type = T;
+
+  AlignedAllocator() = default;
+
+  template <class U>
+  AlignedAllocator(const AlignedAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(
+        ::operator new(n * sizeof(T), std::align_val_t{soa_alignment}));
+  }
+
+  void deallocate(T* p, std::size_t) {
+    ::operator delete(p, std::align_val_t{soa_alignment});
+  }
+
+  template <class U>
+  bool operator==(const AlignedAllocator<U>&) const {
+    return true;
+  }
+};
+
+namespace detail {
+template <class MemberPointer>
+struct member_type;
+
+template <class T, class Field>
+struct member_type<Field T::*> {
+  using type = Field;
+};
+
+template <class T>
+using soa_fields = std::remove_cvref_t<decltype(soa_layout<T>::fields)>;
+
+template <class T, std::size_t I>
+using soa_field_type =
+    typename member_type<std::tuple_element_t<I, soa_fields<T>>>::type;
+};  // namespace detail
+
+// GenerationalIndexArray counterpart keeping each field of T in its own
+// aligned packed array. Components are read and written by value.
+template <soa_component T>
+class SoAIndexArray : public IndexArrayBase {
+  static constexpr std::size_t field_count =
+      std::tuple_size_v<detail::soa_fields<T>>;
+  using FieldSequence = std::make_index_sequence<field_count>;
+
+  template <class Sequence>
+  struct columns_for;
+
+  template <std::size_t... I>
+  struct columns_for<std::index_sequence<I...>> {
+    using type = std::tuple<std::vector<detail::soa_field_type<T, I>,
+                                        AlignedAllocator<
+                                            detail::soa_field_type<T, I>>>...>;
+  };
+
+ public:
+  using value_type = T;
+  using Columns = typename columns_for<FieldSequence>::type;
+
+  // Per field buffer of up to Size components, used to gather scattered
+  // components into contiguous lanes.
+  template <std::size_t Size>
+  struct Batch {
+    template <class Sequence>
+    struct storage_for;
+
+    template <std::size_t... I>
+    struct storage_for<std::index_sequence<I...>> {
+      using type =
+          std::tuple<std::array<detail::soa_field_type<T, I>, Size>...>;
+    };
+
+    alignas(soa_alignment) typename storage_for<FieldSequence>::type fields;
+  };
+
+  SoAIndexArray() = default;
+  virtual ~SoAIndexArray() = default;
+
+  template <typename... Args>
+  bool emplace(const GenerationalIndex& index, Args&&... args) {
+    if (_indices.contains(index.index()))
+      return false;
+    if (_data_ids.size() >= max_generational_index_array_size) {
+      throw std::length_error("SoAIndexArray is full.");
+    }
+    const T value(std::forward<Args>(args)...);
+    _data_ids.push_back(index);
+    for_fields([&]<std::size_t I>() {
+      std::get<I>(_columns).push_back(
+          value.*std::get<I>(soa_layout<T>::fields));
+    });
+    _indices.set(index.index(), _data_ids.size() - 1);
+    return true;
+  }
+
+  inline void reserve(std::size_t capacity) {
+    _data_ids.reserve(capacity);
+    for_fields(
+        [&]<std::size_t I>() { std::get<I>(_columns).reserve(capacity); });
+  }
+
+  template <typename Generator>
+    requires std::invocable<Generator&, std::size_t>
+  std::size_t emplace_bulk(std::span<const GenerationalIndex> indices,
+                           Generator make) {
+    reserve(_data_ids.size() + indices.size());
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < indices.size(); i++) {
+      if (emplace(indices[i], make(i)))
+        added++;
+    }
+    return added;
+  }
+
+  std::size_t remove_bulk(std::span<const GenerationalIndex> indices) {
+    std::size_t removed = 0;
+    for (const auto& index : indices) {
+      if (contains(index)) {
+        remove(index);
+        removed++;
+      }
+    }
+    return removed;
+  }
+
+  T get(const GenerationalIndex& index) const {
+    return load(check_and_translate_index(index));
+  }
+
+  void set(const GenerationalIndex& index, const T& value) {
+    store(check_and_translate_index(index), value);
+  }
+
+  inline bool contains(const GenerationalIndex& index) const {
+    return position(index) != PagedSparseArray::tombstone;
+  }
+
+  // Packed position of index, or tombstone when absent.
+  inline SparseArrayIndexType position(const GenerationalIndex& index) const {
+    auto packed_array_index = _indices.get(index.index());
+    if (packed_array_index == PagedSparseArray::tombstone ||
+        _data_ids[packed_array_index].generation() != index.generation())
+      return PagedSparseArray::tombstone;
+    return packed_array_index;
+  }
+
+  void remove(const GenerationalIndex& index) {
+    auto remove_id = check_and_translate_index(index);
+    auto swap_id = _data_ids.size() - 1;
+    if (remove_id != swap_id) {
+      _indices.set(_data_ids[swap_id].index(), remove_id);
+      _data_ids[remove_id] = _data_ids[swap_id];
+      for_fields([&]<std::size_t I>() {
+        auto& column = std::get<I>(_columns);
+        column[remove_id] = column[swap_id];
+      });
+    }
+    _indices.reset(index.index());
+    _data_ids.pop_back();
+    for_fields([&]<std::size_t I>() { std::get<I>(_columns).pop_back(); });
+  }
+
+  bool erase(const GenerationalIndex& index) override {
+    if (!contains(index))
+      return false;
+    remove(index);
+    return true;
+  }
+
+  inline const std::vector<GenerationalIndex>& indices() const {
+    return _data_ids;
+  }
+
+  inline std::size_t size() const { return _data_ids.size(); }
+
+  inline bool empty() const { return _data_ids.empty(); }
+
+  IndexArrayStats stats() const override {
+    std::size_t dense = _data_ids.capacity() * sizeof(GenerationalIndex);
+    for_fields([&]<std::size_t I>() {
+      dense += std::get<I>(_columns).capacity() *
+               sizeof(detail::soa_field_type<T, I>);
+    });
+    return {size(), dense, _indices.bytes()};
+  }
+
+  // Packed values of field I, in the same order as indices().
+  template <std::size_t I>
+  inline auto& field() {
+    return std::get<I>(_columns);
+  }
+
+  // Spans over [begin, begin + count) of every field.
+  template <bool Const>
+  auto spans(std::size_t begin, std::size_t count) {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return std::make_tuple(
+          std::span<std::conditional_t<Const,
+                                       const detail::soa_field_type<T, I>,
+                                       detail::soa_field_type<T, I>>>{
+              std::get<I>(_columns).data() + begin, count}...);
+    }(FieldSequence{});
+  }
+
+  template <bool Const, std::size_t Size>
+  static auto spans(Batch<Size>& batch, std::size_t count) {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return std::make_tuple(
+          std::span<std::conditional_t<Const,
+                                       const detail::soa_field_type<T, I>,
+                                       detail::soa_field_type<T, I>>>{
+              std::get<I>(batch.fields).data(), count}...);
+    }(FieldSequence{});
+  }
+
+  template <std::size_t Size>
+  void gather(Batch<Size>& batch, const SparseArrayIndexType* positions,
+              std::size_t count) const {
+    for_fields([&]<std::size_t I>() {
+      const auto& column = std::get<I>(_columns);
+      auto& lanes = std::get<I>(batch.fields);
+      for (std::size_t i = 0; i < count; i++) {
+        lanes[i] = column[positions[i]];
+      }
+    });
+  }
+
+  template <std::size_t Size>
+  void scatter(const Batch<Size>& batch, const SparseArrayIndexType* positions,
+               std::size_t count) {
+    for_fields([&]<std::size_t I>() {
+      auto& column = std::get<I>(_columns);
+      const auto& lanes = std::get<I>(batch.fields);
+      for (std::size_t i = 0; i < count; i++) {
+        column[positions[i]] = lanes[i];
+      }
+    });
+  }
+
+ private:
+  template <typename Func>
+  static void for_fields(Func&& f) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      (f.template operator()<I>(), ...);
+    }(FieldSequence{});
+  }
+
+  T load(std::size_t packed_array_index) const {
+    T value{};
+    for_fields([&]<std::size_t I>() {
+      value.*std::get<I>(soa_layout<T>::fields) =
+          std::get<I>(_columns)[packed_array_index];
+    });
+    return value;
+  }
+
+  void store(std::size_t packed_array_index, const T& value) {
+    for_fields([&]<std::size_t I>() {
+      std::get<I>(_columns)[packed_array_index] =
+          value.*std::get<I>(soa_layout<T>::fields);
+    });
+  }
+
+  SparseArrayIndexType check_and_translate_index(
+      const GenerationalIndex& index) const {
+    auto packed_array_index = position(index);
+    if (packed_array_index == PagedSparseArray::tombstone) {
+      throw std::out_of_range(
+          fmt::format("SoAIndexArray accessed non-existent index: {} {}",
+                      index.index(), index.generation()));
+    }
+    return packed_array_index;
+  }
+
+  PagedSparseArray _indices;
+  std::vector<GenerationalIndex> _data_ids;
+  Columns _columns;
+};
+
+namespace detail {
+template <class... ArrayType>
+bool same_packed_order(const ArrayType&... arrays) {
+  const auto& first = std::get<0>(std::tie(arrays...)).indices();
+  auto matches = [&](const auto& array) {
+    const auto& ids = array.indices();
+    if (ids.size() != first.size())
+      return false;
+    for (std::size_t i = 0; i < ids.size(); i++) {
+      if (ids[i].index() != first[i].index() ||
+          ids[i].generation() != first[i].generation())
+        return false;
+    }
+    return true;
+  };
+  return (matches(arrays) && ...);
+}
+
+// Most values per register over the fields of T.
+template <class T>
+constexpr std::size_t soa_max_lanes() {
+  return [&]<std::size_t... I>(std::index_sequence<I...>) {
+    return std::max({simd_lanes<soa_field_type<T, I>>...});
+  }(std::make_index_sequence<std::tuple_size_v<soa_fields<T>>>{});
+}
+};  // namespace detail
+
+// Calls f with one span per field of every ComponentSpec, in declaration
+// order, covering a run of entities that have all of them. Spans of const
+// ComponentSpec are read only. When every pool stores its entities in the
+// same packed order f gets the packed arrays directly, otherwise components
+// are gathered into aligned batches sized for the target's registers and
+// written back afterwards.
+//   foreach_simd<PositionComponent, const VelocityComponent>(
+//       registry, [](std::span<int> px, std::span<int> py,
+//                    std::span<const int> vx, std::span<const int> vy) {
+//         for (std::size_t i = 0; i < px.size(); i++) { ... }
+//       });
+template <class... ComponentSpec, class RegistryType, typename Func>
+void foreach_simd(RegistryType& registry, Func f) {
+  static_assert((soa_component<std::remove_const_t<ComponentSpec>> && ...),
+                "foreach_simd requires soa_layout components.");
+  auto arrays = std::tie(
+      registry.template pool<std::remove_const_t<ComponentSpec>>()...);
+  constexpr auto sequence = std::index_sequence_for<ComponentSpec...>{};
+
+  const bool aligned = std::apply(
+      [](auto&... a) { return detail::same_packed_order(a...); }, arrays);
+  if (aligned) {
+    const std::size_t size = std::get<0>(arrays).size();
+    if (size == 0)
+      return;
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      std::apply(f, std::tuple_cat(
+                        std::get<I>(arrays)
+                            .template spans<std::is_const_v<ComponentSpec>>(
+                                0, size)...));
+    }(sequence);
+    return;
+  }
+
+  constexpr std::size_t batch_size =
+      8 * std::max({detail::soa_max_lanes<
+               std::remove_const_t<ComponentSpec>>()...});
+  std::tuple<typename SoAIndexArray<std::remove_const_t<
+      ComponentSpec>>::template Batch<batch_size>...>
+      batches;
+  std::array<std::array<SparseArrayIndexType, batch_size>,
+             sizeof...(ComponentSpec)>
+      positions;
+  std::size_t count = 0;
+
+  auto flush = [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (std::get<I>(arrays).gather(std::get<I>(batches), positions[I].data(),
+                                count),
+     ...);
+    std::apply(f, std::tuple_cat(
+                      std::remove_reference_t<decltype(std::get<I>(arrays))>::
+                          template spans<std::is_const_v<ComponentSpec>>(
+                              std::get<I>(batches), count)...));
+    (
+        [&] {
+          if constexpr (!std::is_const_v<ComponentSpec>) {
+            std::get<I>(arrays).scatter(std::get<I>(batches),
+                                        positions[I].data(), count);
+          }
+        }(),
+        ...);
+    count = 0;
+  };
+
+  const std::array<std::size_t, sizeof...(ComponentSpec)> sizes =
+      std::apply([](auto&... a) { return std::array{a.size()...}; }, arrays);
+  const std::size_t driver =
+      std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+  const auto ids = [&]<std::size_t... I>(std::index_sequence<I...>) {
+    std::span<const GenerationalIndex> result;
+    ((driver == I ? (result = std::get<I>(arrays).indices(), true) : false) ||
+     ...);
+    return result;
+  }(sequence);
+
+  for (const auto& id : ids) {
+    const bool found = [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return ((positions[I][count] = std::get<I>(arrays).position(id),
+               positions[I][count] != PagedSparseArray::tombstone) &&
+              ...);
+    }(sequence);
+    if (!found)
+      continue;
+    if (++count == batch_size) {
+      flush(sequence);
+    }
+  }
+  if (count > 0) {
+    flush(sequence);
+  }
+}
+};  // namespace engine
+#endif
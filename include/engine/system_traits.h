@@ -0,0 +1,58 @@
+#ifndef ENGINE_SYSTEM_TRAITS_H
+#define ENGINE_SYSTEM_TRAITS_H
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace engine {
+
+namespace detail {
+template <typename Func>
+struct system_traits : system_traits<decltype(&Func::operator())> {};
+
+template <typename R, typename... Args>
+struct system_traits<R (*)(Args...)> {
+  using arguments = std::tuple<Args...>;
+};
+
+template <typename C, typename R, typename... Args>
+struct system_traits<R (C::*)(Args...)> : system_traits<R (*)(Args...)> {};
+
+template <typename C, typename R, typename... Args>
+struct system_traits<R (C::*)(Args...) const>
+    : system_traits<R (*)(Args...)> {};
+
+// Parameters taken by non-const reference or pointer are written, all others
+// read.
+template <typename Arg>
+constexpr bool writes_argument =
+    (std::is_lvalue_reference_v<Arg> &&
+     !std::is_const_v<std::remove_reference_t<Arg>>) ||
+    (std::is_pointer_v<Arg> && !std::is_const_v<std::remove_pointer_t<Arg>>);
+
+template <std::size_t Count>
+using write_flags = std::array<bool, Count>;
+
+// Which of f's Count component parameters are written. Generic callables
+// can't be inspected and are assumed to write every component.
+template <typename Func, std::size_t Count>
+constexpr write_flags<Count> written_components() {
+  write_flags<Count> writes{};
+  writes.fill(true);
+  if constexpr (std::is_pointer_v<Func> || requires { &Func::operator(); }) {
+    using Arguments = typename system_traits<Func>::arguments;
+    if constexpr (std::tuple_size_v<Arguments> == Count) {
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((writes[I] = writes_argument<std::tuple_element_t<I, Arguments>>),
+         ...);
+      }(std::make_index_sequence<Count>{});
+    }
+  }
+  return writes;
+}
+};  // namespace detail
+};  // namespace engine
+#endif
@@ -0,0 +1,152 @@
+#ifndef ENGINE_TAG_H
+#define ENGINE_TAG_H
+
+#include <engine/generational_index.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// Entity indices per word of a tag bitset.
+constexpr std::size_t tag_word_bits{64};
+
+// Empty component types, e.g. struct Enemy {}, only mark entities, so
+// ComponentRegistry keeps them as a bit per entity instead of a pool.
+template <class T>
+concept tag_component =
+    std::is_empty_v<T> && std::is_default_constructible_v<T>;
+
+// Bitset of the entity indices holding tag T, with no packed ids, values or
+// ticks. Bits don't record generations: the owning ComponentRegistry checks
+// those through its entity masks and clears an entity's bits when its
+// components are removed.
+template <tag_component T>
+class TagIndexArray : public IndexArrayBase {
+ public:
+  using value_type = T;
+
+  explicit TagIndexArray(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : _words(resource) {}
+
+  // Sets index's bit. False when it is already set, possibly by an older
+  // generation of index.
+  template <typename... Args>
+  bool emplace(const GenerationalIndex& index, Args&&... args) {
+    static_cast<void>(T(std::forward<Args>(args)...));
+    const auto [word, bit] = locate(index);
+    if (word >= _words.size()) {
+      _words.resize(word + 1, 0);
+    }
+    if ((_words[word] & bit) != 0)
+      return false;
+    _words[word] |= bit;
+    _size++;
+    return true;
+  }
+
+  inline bool contains(const GenerationalIndex& index) const {
+    const auto [word, bit] = locate(index);
+    return word < _words.size() && (_words[word] & bit) != 0;
+  }
+
+  void remove(const GenerationalIndex& index) {
+    if (!erase(index)) {
+      throw std::out_of_range("TagIndexArray accessed non-existent index.");
+    }
+  }
+
+  bool erase(const GenerationalIndex& index) override {
+    if (!contains(index))
+      return false;
+    const auto [word, bit] = locate(index);
+    _words[word] &= ~bit;
+    _size--;
+    return true;
+  }
+
+  // Tags hold no data, every index shares one value.
+  T& get(const GenerationalIndex& index) {
+    if (!contains(index)) {
+      throw std::out_of_range("TagIndexArray accessed non-existent index.");
+    }
+    return _value;
+  }
+
+  inline T& get_unchecked(const GenerationalIndex&) { return _value; }
+
+  inline const T& get_unchecked(const GenerationalIndex&) const {
+    return _value;
+  }
+
+  // Bit i of word w stands for entity index w * tag_word_bits + i.
+  inline std::span<const std::uint64_t> words() const { return _words; }
+
+  inline std::size_t size() const { return _size; }
+
+  inline bool empty() const { return _size == 0; }
+
+  inline std::pmr::memory_resource* resource() const {
+    return _words.get_allocator().resource();
+  }
+
+  IndexArrayStats stats() const override {
+    return {_size, _words.capacity() * sizeof(std::uint64_t), 0};
+  }
+
+ private:
+  static constexpr std::pair<std::size_t, std::uint64_t> locate(
+      const GenerationalIndex& index) {
+    return {index.index() / tag_word_bits,
+            std::uint64_t{1} << (index.index() % tag_word_bits)};
+  }
+
+  std::pmr::vector<std::uint64_t> _words;
+  std::size_t _size = 0;
+  [[no_unique_address]] T _value{};
+};
+
+namespace detail {
+template <class Array>
+constexpr bool is_tag_array = false;
+
+template <tag_component T>
+constexpr bool is_tag_array<TagIndexArray<T>> = true;
+
+template <tag_component T>
+constexpr bool is_tag_array<const TagIndexArray<T>> = true;
+
+// Calls f(index) for every entity index set in all of words, ANDing them a
+// word at a time.
+template <std::size_t Count, typename Func>
+void foreach_common_index(
+    const std::array<std::span<const std::uint64_t>, Count>& words, Func&& f) {
+  static_assert(Count > 0);
+  std::size_t size = words[0].size();
+  for (const auto& span : words) {
+    size = std::min(size, span.size());
+  }
+  for (std::size_t w = 0; w < size; w++) {
+    std::uint64_t word = words[0][w];
+    for (std::size_t i = 1; i < Count; i++) {
+      word &= words[i][w];
+    }
+    while (word != 0) {
+      f(static_cast<GenerationalIndexType>(w * tag_word_bits +
+                                           std::countr_zero(word)));
+      word &= word - 1;
+    }
+  }
+}
+};  // namespace detail
+};  // namespace engine
+#endif
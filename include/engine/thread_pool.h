@@ -0,0 +1,62 @@
+#ifndef ENGINE_THREAD_POOL_H
+#define ENGINE_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+class ThreadPool {
+ public:
+  // Zero threads uses std::thread::hardware_concurrency().
+  explicit ThreadPool(std::size_t threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  template <typename Func>
+  std::future<void> submit(Func f) {
+    auto task = std::make_shared<std::packaged_task<void()>>(std::move(f));
+    auto future = task->get_future();
+    {
+      std::lock_guard lock{_mutex};
+      _tasks.emplace([task] { (*task)(); });
+    }
+    _task_ready.notify_one();
+    return future;
+  }
+
+  // Runs task(i) for every i in [0, count) and waits for all of them. The
+  // calling thread takes part, so this may be nested inside a pool task.
+  void parallel_for(std::size_t count,
+                    const std::function<void(std::size_t)>& task);
+
+  inline std::size_t size() const { return _workers.size(); }
+
+  // 1 + the worker's position on this pool's threads, 0 on any other thread.
+  // Indexes per thread state such as one CommandBuffer per worker.
+  std::size_t worker_index() const;
+
+ private:
+  void worker_loop();
+  bool run_pending_task();
+
+  std::vector<std::thread> _workers;
+  std::queue<std::function<void()>> _tasks;
+  std::mutex _mutex;
+  std::condition_variable _task_ready;
+  bool _stopping = false;
+};
+
+// Process wide pool shared by parallel_foreach and friends.
+ThreadPool& default_thread_pool();
+};  // namespace engine
+#endif
@@ -2,69 +2,189 @@
 #define ENGINE_TYPE_MAP_H
 
 #include <atomic>
-#include <stdexcept>
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // ref: https://gpfault.net/posts/mapping-types-to-values.txt.html
 namespace engine {
 
+namespace detail {
+// The compiler's signature of this function, which spells out T.
+template <class T>
+constexpr std::string_view type_signature() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return __FUNCSIG__;
+#else
+  return __PRETTY_FUNCTION__;
+#endif
+}
+};  // namespace detail
+
+// FNV-1a hash of T's name as spelled by the compiler. Unlike TypeMap's ids
+// it doesn't depend on use order, so it is the same in every run of builds
+// from the same compiler and can identify types in files and messages.
+template <class T>
+constexpr std::uint64_t stable_type_id() {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (char c : detail::type_signature<T>()) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+// Maps types to values. Each key type gets a small id, in first use order,
+// that indexes a dense vector, so lookups are O(1) without hashing. Ids are
+// shared by every TypeMap with the same ValueType.
 template <class ValueType>
 class TypeMap {
-  // Internally, we'll use a hash table to store mapping from type
-  // IDs to the values.
-  typedef std::unordered_map<int, ValueType> InternalMap;
+ public:
+  typedef std::pair<const int, ValueType> value_type;
+
+ private:
+  typedef std::vector<std::optional<value_type>> Entries;
+
+  // Walks the set entries in id order.
+  template <class EntryIterator, class Value>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<Value>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    Iterator() = default;
+
+    Iterator(EntryIterator it, EntryIterator end) : _it(it), _end(end) {
+      skip_unset();
+    }
+
+    inline reference operator*() const { return **_it; }
+
+    inline pointer operator->() const { return &**_it; }
+
+    inline Iterator& operator++() {
+      ++_it;
+      skip_unset();
+      return *this;
+    }
+
+    inline Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    inline bool operator==(const Iterator& other) const {
+      return _it == other._it;
+    }
+
+   private:
+    inline void skip_unset() {
+      while (_it != _end && !_it->has_value()) {
+        ++_it;
+      }
+    }
+
+    EntryIterator _it{};
+    EntryIterator _end{};
+  };
 
  public:
-  typedef typename InternalMap::iterator iterator;
-  typedef typename InternalMap::const_iterator const_iterator;
-  typedef typename InternalMap::value_type value_type;
+  typedef Iterator<typename Entries::iterator, value_type> iterator;
+  typedef Iterator<typename Entries::const_iterator, const value_type>
+      const_iterator;
 
-  inline const_iterator begin() const { return m_map.begin(); }
+  inline const_iterator begin() const {
+    return {_entries.begin(), _entries.end()};
+  }
 
-  inline const_iterator end() const { return m_map.end(); }
+  inline const_iterator end() const { return {_entries.end(), _entries.end()}; }
 
-  inline iterator begin() { return m_map.begin(); }
+  inline iterator begin() { return {_entries.begin(), _entries.end()}; }
 
-  inline iterator end() { return m_map.end(); }
+  inline iterator end() { return {_entries.end(), _entries.end()}; }
 
   // Finds the value associated with the type "Key" in the type map.
   template <class Key>
   inline iterator find() {
-    return m_map.find(getTypeId<Key>());
+    const auto id = static_cast<std::size_t>(type_id<Key>());
+    if (id >= _entries.size() || !_entries[id])
+      return end();
+    return {_entries.begin() + id, _entries.end()};
   }
 
+  // Same as above, const version
   template <class Key>
-  inline bool contains() {
-    return m_map.contains(getTypeId<Key>());
+  inline const_iterator find() const {
+    const auto id = static_cast<std::size_t>(type_id<Key>());
+    if (id >= _entries.size() || !_entries[id])
+      return end();
+    return {_entries.begin() + id, _entries.end()};
   }
 
-  // Same as above, const version
   template <class Key>
-  inline const_iterator find() const {
-    return m_map.find(getTypeId<Key>());
+  inline bool contains() const {
+    return get<Key>() != nullptr;
+  }
+
+  // Value of "Key", or nullptr.
+  template <class Key>
+  inline ValueType* get() {
+    const auto id = static_cast<std::size_t>(type_id<Key>());
+    return id < _entries.size() && _entries[id] ? &_entries[id]->second
+                                                : nullptr;
+  }
+
+  template <class Key>
+  inline const ValueType* get() const {
+    return const_cast<TypeMap*>(this)->get<Key>();
   }
 
   // Associates a value with the type "Key"
   template <class Key>
   inline void put(ValueType&& value) {
-    m_map[getTypeId<Key>()] = std::forward<ValueType>(value);
+    auto& entry = assure(type_id<Key>());
+    entry.reset();
+    entry.emplace(type_id<Key>(), std::forward<ValueType>(value));
   }
 
   template <class Key, typename... Args>
   inline bool emplace(Args&&... args) {
-    return m_map.try_emplace(getTypeId<Key>(), std::forward<Args>(args)...)
-        .second;
+    auto& entry = assure(type_id<Key>());
+    if (entry)
+      return false;
+    entry.emplace(std::piecewise_construct,
+                  std::forward_as_tuple(type_id<Key>()),
+                  std::forward_as_tuple(std::forward<Args>(args)...));
+    return true;
   }
 
- private:
+  // Key's index into the dense storage.
   template <class Key>
-  inline static int getTypeId() {
+  inline static int type_id() {
     static const int id = LastTypeId++;
     return id;
   }
 
+ private:
+  inline std::optional<value_type>& assure(int id) {
+    const auto index = static_cast<std::size_t>(id);
+    if (index >= _entries.size()) {
+      _entries.resize(index + 1);
+    }
+    return _entries[index];
+  }
+
   static std::atomic_int LastTypeId;
-  InternalMap m_map;
+  Entries _entries;
 };
 
 template <class ValueType>
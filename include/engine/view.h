@@ -0,0 +1,143 @@
+#ifndef ENGINE_VIEW_H
+#define ENGINE_VIEW_H
+
+#include <engine/generational_index.h>
+#include <engine/soa.h>
+#include <engine/tag.h>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace engine {
+
+// Lazy range over the indices present in every one of Array..., yielding
+// std::tuple<GenerationalIndex, T&...> with T const for const arrays. The
+// smallest array drives and the others are probed per candidate, so
+// nothing is allocated and stopping early skips the rest of the
+// intersection. Works with std::views such as take and filter.
+//
+// Components of non-const arrays are marked as changed when dereferenced.
+// Adding or removing components invalidates iterators.
+template <class... Array>
+class View : public std::ranges::view_interface<View<Array...>> {
+  static_assert(sizeof...(Array) > 0);
+  static_assert(!(soa_component<typename Array::value_type> || ...),
+                "soa_layout components are iterated with foreach_simd.");
+  static_assert(!(detail::is_tag_array<Array> && ...),
+                "Tags only filter, a component must drive iteration.");
+
+ public:
+  using value_type =
+      std::tuple<GenerationalIndex,
+                 std::conditional_t<std::is_const_v<Array>,
+                                    const typename Array::value_type&,
+                                    typename Array::value_type&>...>;
+
+  class Iterator {
+   public:
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = View::value_type;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+
+    Iterator(const View* view, std::size_t position)
+        : _view(view), _position(position) {
+      skip_unmatched();
+    }
+
+    inline value_type operator*() const { return _view->fetch(_position); }
+
+    inline Iterator& operator++() {
+      ++_position;
+      skip_unmatched();
+      return *this;
+    }
+
+    inline Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    inline bool operator==(const Iterator& other) const {
+      return _position == other._position;
+    }
+
+   private:
+    inline void skip_unmatched() {
+      while (_position < _view->_ids.size() && !_view->matches(_position)) {
+        ++_position;
+      }
+    }
+
+    const View* _view = nullptr;
+    std::size_t _position = 0;
+  };
+
+  View() = default;
+
+  explicit View(Array&... arrays) : _arrays(&arrays...) {
+    std::size_t smallest = std::numeric_limits<std::size_t>::max();
+    std::size_t i = 0;
+    (
+        [&] {
+          if constexpr (!detail::is_tag_array<Array>) {
+            if (arrays.size() < smallest) {
+              smallest = arrays.size();
+              _ids = arrays.indices();
+              _driver = i;
+            }
+          }
+          i++;
+        }(),
+        ...);
+  }
+
+  inline Iterator begin() const { return {this, 0}; }
+
+  inline Iterator end() const { return {this, _ids.size()}; }
+
+ private:
+  static constexpr auto sequence = std::index_sequence_for<Array...>{};
+
+  inline bool matches(std::size_t position) const {
+    const auto& id = _ids[position];
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return ((I == _driver || std::get<I>(_arrays)->contains(id)) && ...);
+    }(sequence);
+  }
+
+  inline value_type fetch(std::size_t position) const {
+    const auto& id = _ids[position];
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return value_type{id, component<I>(id)...};
+    }(sequence);
+  }
+
+  template <std::size_t I>
+  inline decltype(auto) component(const GenerationalIndex& id) const {
+    auto& array = *std::get<I>(_arrays);
+    using ArrayType = std::remove_reference_t<decltype(array)>;
+    if constexpr (std::is_const_v<ArrayType> ||
+                  detail::is_tag_array<ArrayType>) {
+      return array.get_unchecked(id);
+    } else {
+      const auto packed = array.position_unchecked(id);
+      array.touch_at(packed);
+      return (array.values()[packed]);
+    }
+  }
+
+  std::tuple<Array*...> _arrays{};
+  std::span<const GenerationalIndex> _ids;
+  std::size_t _driver = 0;
+};
+};  // namespace engine
+#endif
@@ -0,0 +1,104 @@
+#ifndef ENGINE_WORLD_H
+#define ENGINE_WORLD_H
+
+#include <engine/ecs.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// Component registry for a component set fixed at compile time. Pools live
+// in a tuple and are resolved by type, so accesses compile down to the packed
+// arrays with no type erasure or hashing. Mirrors the ComponentRegistry API.
+template <class... ComponentType>
+class World {
+ public:
+  template <class T>
+  static constexpr bool contains_type =
+      (std::is_same_v<T, ComponentType> || ...);
+
+  World() = default;
+
+  // Every component type is registered by the template argument list, so
+  // this only exists for API compatibility and always returns false.
+  template <class T>
+  constexpr bool register_component() {
+    static_assert(contains_type<T>, "Component type is not part of World.");
+    return false;
+  }
+
+  template <class T, typename... Args>
+  bool add_component(Entity id, Args&&... args) {
+    return pool<T>().emplace(id, std::forward<Args>(args)...);
+  }
+
+  template <class T>
+  bool remove_component(Entity id) {
+    auto& entity_map = pool<T>();
+    if (!entity_map.contains(id))
+      return false;
+    entity_map.remove(id);
+    return true;
+  }
+
+  template <class T>
+  std::vector<Entity> has_component() {
+    const auto& indices = pool<T>().indices();
+    return {indices.begin(), indices.end()};
+  }
+
+  template <class First, class Second, class... Rest>
+  std::vector<Entity> has_component() {
+    std::vector<Entity> entities;
+    detail::foreach_arrays(
+        [&](const Entity& id, const auto&...) { entities.push_back(id); },
+        pool<First>(), pool<Second>(), pool<Rest>()...);
+    return entities;
+  }
+
+  template <class T>
+  auto component_accessor() {
+    auto& entity_map = pool<T>();
+    return [&](Entity id) -> T& {
+      return entity_map.get(id);
+    };
+  }
+
+  template <class T>
+  T& get_component(Entity id) {
+    return pool<T>().get(id);
+  }
+
+  template <class T>
+  inline EntityMap<T>& pool() {
+    static_assert(contains_type<T>, "Component type is not part of World.");
+    return std::get<EntityMap<T>>(_pools);
+  }
+
+  // Lazy range over the entities with every ...T, see
+  // ComponentRegistry::view.
+  template <class... T>
+  View<std::conditional_t<std::is_const_v<T>,
+                          const EntityMap<std::remove_const_t<T>>,
+                          EntityMap<T>>...>
+  view() {
+    return View<std::conditional_t<std::is_const_v<T>,
+                                   const EntityMap<std::remove_const_t<T>>,
+                                   EntityMap<T>>...>{
+        pool<std::remove_const_t<T>>()...};
+  }
+
+  template <class... T, typename Func>
+  void each(Func f) {
+    detail::foreach_arrays(
+        [&f](const Entity&, auto&... components) { f(components...); },
+        pool<T>()...);
+  }
+
+ private:
+  std::tuple<EntityMap<ComponentType>...> _pools;
+};
+};  // namespace engine
+#endif
@@ -0,0 +1,207 @@
+#include <engine/archetype.h>
+#include <algorithm>
+#include <new>
+
+using namespace engine;
+
+namespace {
+constexpr std::size_t chunk_alignment{64};
+
+std::size_t align_up(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+Archetype::Archetype(std::vector<ComponentInfo> components)
+    : _components(std::move(components)), _offsets(_components.size()) {
+  // Bytes needed for a chunk of capacity rows, filling in column offsets.
+  auto layout = [&](std::size_t capacity) {
+    std::size_t bytes = capacity * sizeof(Entity);
+    for (std::size_t i = 0; i < _components.size(); i++) {
+      bytes = align_up(bytes, _components[i].alignment);
+      _offsets[i] = bytes;
+      bytes += capacity * _components[i].size;
+    }
+    return bytes;
+  };
+  std::size_t row_bytes = sizeof(Entity);
+  for (const auto& info : _components) {
+    row_bytes += info.size;
+  }
+  _capacity = std::max<std::size_t>(1, archetype_chunk_size / row_bytes);
+  while (_capacity > 1 && layout(_capacity) > archetype_chunk_size) {
+    _capacity--;
+  }
+  _bytes = align_up(std::max(layout(_capacity), archetype_chunk_size),
+                    chunk_alignment);
+}
+
+Archetype::~Archetype() {
+  for (std::size_t chunk = 0; chunk < _chunks.size(); chunk++) {
+    for (std::size_t row = 0; row < _chunks[chunk].size; row++) {
+      for (std::size_t column = 0; column < _components.size(); column++) {
+        _components[column].destroy(get(column, {chunk, row}));
+      }
+      std::destroy_at(&entity({chunk, row}));
+    }
+    ::operator delete(_chunks[chunk].data, std::align_val_t{chunk_alignment});
+  }
+}
+
+std::size_t Archetype::column(std::type_index type) const {
+  auto it = std::lower_bound(_components.begin(), _components.end(), type,
+                             [](const ComponentInfo& info, std::type_index t) {
+                               return info.type < t;
+                             });
+  if (it == _components.end() || it->type != type)
+    return npos;
+  return it - _components.begin();
+}
+
+ArchetypeSlot Archetype::allocate(const Entity& id) {
+  if (_chunks.empty() || _chunks.back().size == _capacity) {
+    _chunks.push_back({static_cast<std::byte*>(::operator new(
+                           _bytes, std::align_val_t{chunk_alignment})),
+                       0});
+  }
+  ArchetypeSlot slot{_chunks.size() - 1, _chunks.back().size};
+  std::construct_at(&entity(slot), id);
+  _chunks.back().size++;
+  _size++;
+  return slot;
+}
+
+std::optional<Entity> Archetype::release(const ArchetypeSlot& slot) {
+  ArchetypeSlot last{_chunks.size() - 1, _chunks.back().size - 1};
+  std::optional<Entity> moved;
+  if (slot.chunk != last.chunk || slot.row != last.row) {
+    for (std::size_t column = 0; column < _components.size(); column++) {
+      _components[column].relocate(get(column, slot), get(column, last));
+    }
+    entity(slot) = entity(last);
+    moved = entity(slot);
+  }
+  std::destroy_at(&entity(last));
+  _size--;
+  if (--_chunks.back().size == 0) {
+    ::operator delete(_chunks.back().data, std::align_val_t{chunk_alignment});
+    _chunks.pop_back();
+  }
+  return moved;
+}
+
+std::optional<Entity> Archetype::erase(const ArchetypeSlot& slot) {
+  for (std::size_t column = 0; column < _components.size(); column++) {
+    _components[column].destroy(get(column, slot));
+  }
+  return release(slot);
+}
+
+bool ArchetypeRegistry::remove_all(Entity id) {
+  if (!_locations.contains(id))
+    return false;
+  auto& location = _locations.get(id);
+  auto moved = location.archetype->erase(location.slot);
+  if (moved) {
+    _locations.get(*moved).slot = location.slot;
+  }
+  _locations.remove(id);
+  return true;
+}
+
+const ComponentInfo& ArchetypeRegistry::registered_info(
+    std::type_index type) const {
+  auto it = _infos.find(type);
+  if (it == _infos.end()) {
+    throw std::runtime_error(
+        "Adding component but component type was not registered.");
+  }
+  return it->second;
+}
+
+Archetype* ArchetypeRegistry::with_component(Archetype* source,
+                                             const ComponentInfo& info) {
+  if (source == nullptr) {
+    return find_or_create({info});
+  }
+  auto edge = source->add_edges.find(info.type);
+  if (edge != source->add_edges.end()) {
+    return edge->second;
+  }
+  auto components = source->components();
+  components.insert(
+      std::upper_bound(components.begin(), components.end(), info,
+                       [](const ComponentInfo& a, const ComponentInfo& b) {
+                         return a.type < b.type;
+                       }),
+      info);
+  auto* target = find_or_create(std::move(components));
+  source->add_edges[info.type] = target;
+  target->remove_edges[info.type] = source;
+  return target;
+}
+
+Archetype* ArchetypeRegistry::without_component(Archetype* source,
+                                                const ComponentInfo& info) {
+  auto edge = source->remove_edges.find(info.type);
+  if (edge != source->remove_edges.end()) {
+    return edge->second;
+  }
+  auto components = source->components();
+  std::erase_if(components, [&](const ComponentInfo& component) {
+    return component.type == info.type;
+  });
+  if (components.empty()) {
+    return nullptr;
+  }
+  auto* target = find_or_create(std::move(components));
+  source->remove_edges[info.type] = target;
+  target->add_edges[info.type] = source;
+  return target;
+}
+
+Archetype* ArchetypeRegistry::find_or_create(
+    std::vector<ComponentInfo> components) {
+  std::vector<std::type_index> signature;
+  signature.reserve(components.size());
+  for (const auto& info : components) {
+    signature.push_back(info.type);
+  }
+  auto it = _signatures.find(signature);
+  if (it != _signatures.end()) {
+    return it->second;
+  }
+  _archetypes.push_back(std::make_unique<Archetype>(std::move(components)));
+  auto* archetype = _archetypes.back().get();
+  _signatures.emplace(std::move(signature), archetype);
+  return archetype;
+}
+
+void ArchetypeRegistry::move_entity(const Entity& id, Archetype* target,
+                                    const ArchetypeSlot& slot) {
+  if (!_locations.contains(id)) {
+    _locations.emplace(id, Location{target, slot});
+    return;
+  }
+  auto& location = _locations.get(id);
+  auto* source = location.archetype;
+  const auto& components = source->components();
+  for (std::size_t column = 0; column < components.size(); column++) {
+    auto target_column = target->column(components[column].type);
+    if (target_column != Archetype::npos) {
+      components[column].relocate(target->get(target_column, slot),
+                                  source->get(column, location.slot));
+    }
+  }
+  auto old_slot = location.slot;
+  location = {target, slot};
+  release(source, old_slot);
+}
+
+void ArchetypeRegistry::release(Archetype* archetype,
+                                const ArchetypeSlot& slot) {
+  auto moved = archetype->release(slot);
+  if (moved) {
+    _locations.get(*moved).slot = slot;
+  }
+}
@@ -0,0 +1,63 @@
+#include <engine/command_buffer.h>
+#include <map>
+
+using namespace engine;
+
+std::vector<Entity> CommandBuffer::flush(ECS& ecs,
+                                         ComponentRegistry& components) {
+  ecs.flush();
+  auto created = ecs.create_many(_created);
+  for (auto& [type, list] : _lists) {
+    list->apply(components, created);
+  }
+  for (const auto& id : _destroyed) {
+    if (ecs.destroy(id))
+      components.remove_all(id);
+  }
+  clear();
+  return created;
+}
+
+void CommandBuffer::clear() {
+  for (auto& [type, list] : _lists) {
+    list->clear();
+  }
+  _destroyed.clear();
+  _created = 0;
+  _commands = 0;
+}
+
+std::vector<Entity> CommandBuffers::flush(ECS& ecs,
+                                          ComponentRegistry& components) {
+  ecs.flush();
+  std::vector<std::size_t> first_created(_buffers.size());
+  std::size_t count = 0;
+  for (std::size_t b = 0; b < _buffers.size(); b++) {
+    first_created[b] = count;
+    count += _buffers[b]._created;
+  }
+  auto created = ecs.create_many(count);
+
+  // group the lists of every buffer by component type
+  std::map<int, std::vector<std::pair<std::size_t, CommandListBase*>>> lists;
+  for (std::size_t b = 0; b < _buffers.size(); b++) {
+    for (auto& [type, list] : _buffers[b]._lists) {
+      lists[type].emplace_back(b, list.get());
+    }
+  }
+  for (auto& [type, type_lists] : lists) {
+    for (auto& [b, list] : type_lists) {
+      list->apply(components,
+                  std::span<const Entity>{created}.subspan(first_created[b]));
+    }
+  }
+
+  for (auto& buffer : _buffers) {
+    for (const auto& id : buffer._destroyed) {
+      if (ecs.destroy(id))
+        components.remove_all(id);
+    }
+    buffer.clear();
+  }
+  return created;
+}
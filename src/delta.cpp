@@ -0,0 +1,108 @@
+#include <engine/delta.h>
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+using namespace engine;
+
+namespace {
+constexpr std::array<char, 8> delta_magic{'E', 'L', 'D', 'E',
+                                          'R', 'D', 'L', 'T'};
+}  // namespace
+
+void detail::write_delta_header(SnapshotOutput& out, Tick since, Tick tick,
+                                std::size_t components) {
+  DeltaHeader header{};
+  std::copy(delta_magic.begin(), delta_magic.end(), header.magic);
+  header.version = delta_version;
+  header.components = static_cast<std::uint32_t>(components);
+  header.since = since;
+  header.tick = tick;
+  out.write(header);
+}
+
+DeltaHeader detail::read_delta_header(SnapshotInput& in,
+                                      std::size_t components) {
+  const auto header = in.read<DeltaHeader>();
+  if (!std::equal(delta_magic.begin(), delta_magic.end(), header.magic)) {
+    throw std::runtime_error("Not a delta.");
+  }
+  if (header.version != delta_version) {
+    throw std::runtime_error("Unsupported delta version.");
+  }
+  if (header.components != components) {
+    throw std::runtime_error("Delta has different component types.");
+  }
+  return header;
+}
+
+void detail::apply_entities(SnapshotInput& in,
+                            GenerationalIndexAllocator& allocator) {
+  const auto allocated = in.read<std::uint64_t>();
+  const auto changed = in.read<std::uint64_t>();
+  if (allocated < allocator.allocated()) {
+    throw std::runtime_error("Delta shrinks the entity allocator.");
+  }
+  if (changed == 0)
+    return;
+  std::vector<SlotVersion> versions(changed);
+  for (auto& slot : versions) {
+    slot.index = in.read<std::uint32_t>();
+    slot.version = in.read<std::uint32_t>();
+    if (slot.index >= allocated) {
+      throw std::runtime_error("Delta entity is out of range.");
+    }
+  }
+  allocator.patch(allocated, versions);
+}
+
+DeltaEncoder::DeltaEncoder(Registry& registry) : _registry(registry) {
+  _registry.entities.allocator().log_changes(true);
+  _registry.components.log_changes(true);
+}
+
+void DeltaEncoder::encode_entities(SnapshotOutput& out) {
+  auto& allocator = _registry.entities.allocator();
+  const auto entries = allocator.entries();
+  // Slots go in the order they last changed, so the mirror appends freed
+  // slots to its free list in the same order, see patch. The first delta
+  // has the slots in use, then the free list.
+  std::vector<GenerationalIndexType> changed;
+  if (_since == 0) {
+    const auto free = allocator.free_list();
+    std::vector<bool> is_free(entries.size(), false);
+    for (const auto index : free) {
+      is_free[index] = true;
+    }
+    for (std::size_t i = 0; i < entries.size(); i++) {
+      if (!is_free[i])
+        changed.push_back(static_cast<GenerationalIndexType>(i));
+    }
+    changed.insert(changed.end(), free.begin(), free.end());
+  } else {
+    // keeps each slot's last entry in the log
+    const auto log = allocator.changes();
+    std::vector<std::size_t> order(log.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) {
+                       return log[a] < log[b];
+                     });
+    std::vector<std::size_t> last;
+    for (std::size_t i = 0; i < order.size(); i++) {
+      if (i + 1 == order.size() || log[order[i]] != log[order[i + 1]])
+        last.push_back(order[i]);
+    }
+    std::sort(last.begin(), last.end());
+    for (const auto i : last) {
+      changed.push_back(log[i]);
+    }
+  }
+  out.write<std::uint64_t>(entries.size());
+  out.write<std::uint64_t>(changed.size());
+  for (const auto index : changed) {
+    out.write(index);
+    out.write(entries[index].version);
+  }
+  allocator.clear_changes();
+}
@@ -0,0 +1,79 @@
+#include <engine/frame_arena.h>
+#include <algorithm>
+#include <cstdint>
+
+using namespace engine;
+
+namespace {
+constexpr std::size_t block_alignment{alignof(std::max_align_t)};
+}  // namespace
+
+FrameArena::FrameArena(std::size_t capacity,
+                       std::pmr::memory_resource* upstream)
+    : _upstream(upstream) {
+  add_block(std::max<std::size_t>(capacity, 1));
+}
+
+FrameArena::~FrameArena() { release(); }
+
+void FrameArena::reset() {
+  std::lock_guard lock{_mutex};
+  if (_blocks.size() > 1) {
+    std::size_t total = 0;
+    for (const auto& block : _blocks) {
+      total += block.size;
+    }
+    release();
+    add_block(total);
+  }
+  _block = 0;
+  _offset = 0;
+  _used_before = 0;
+}
+
+std::size_t FrameArena::used() const {
+  std::lock_guard lock{_mutex};
+  return _used_before + _offset;
+}
+
+std::size_t FrameArena::capacity() const {
+  std::lock_guard lock{_mutex};
+  std::size_t total = 0;
+  for (const auto& block : _blocks) {
+    total += block.size;
+  }
+  return total;
+}
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  std::lock_guard lock{_mutex};
+  while (true) {
+    const auto& block = _blocks[_block];
+    const auto start = reinterpret_cast<std::uintptr_t>(block.data);
+    const auto aligned =
+        (start + _offset + alignment - 1) / alignment * alignment;
+    if (aligned + bytes <= start + block.size) {
+      _offset = aligned - start + bytes;
+      return reinterpret_cast<void*>(aligned);
+    }
+    _used_before += _offset;
+    _offset = 0;
+    if (_block + 1 == _blocks.size()) {
+      add_block(std::max(bytes + alignment, block.size * 2));
+    }
+    _block++;
+  }
+}
+
+void FrameArena::add_block(std::size_t size) {
+  _blocks.push_back(
+      {static_cast<std::byte*>(_upstream->allocate(size, block_alignment)),
+       size});
+}
+
+void FrameArena::release() {
+  for (const auto& block : _blocks) {
+    _upstream->deallocate(block.data, block.size, block_alignment);
+  }
+  _blocks.clear();
+}
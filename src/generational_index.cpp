@@ -4,30 +4,201 @@
 
 using namespace engine;
 
-GenerationalIndex::GenerationalIndex(GenerationalIndexType index,
-                                     std::uint32_t generation)
-    : _index(index), _generation(generation) {}
-
 GenerationalIndex GenerationalIndexAllocator::allocate() {
-  if (_free.empty()) {
-    _entries.emplace_back();
-    return {static_cast<GenerationalIndexType>(_entries.size()) - 1, 0};
+  flush();
+  if (_free_count > 0) {
+    return pop_free();
+  }
+  if (_entries.size() >= free_list_end) {
+    throw std::length_error("GenerationalIndexAllocator is full.");
   }
-  auto index = _free.front();
-  _free.pop();
+  _entries.emplace_back();
+  const auto index = static_cast<GenerationalIndexType>(_entries.size()) - 1;
+  log_change(index);
+  return {index, 0};
+}
 
-  auto& entry = _entries[index];
-  entry.generation++;
-  entry.is_live = true;
-  return {index, entry.generation};
+std::vector<GenerationalIndex> GenerationalIndexAllocator::allocate(
+    std::size_t count) {
+  flush();
+  std::vector<GenerationalIndex> indices;
+  indices.reserve(count);
+  while (indices.size() < count && _free_count > 0) {
+    indices.push_back(pop_free());
+  }
+  const auto first = static_cast<GenerationalIndexType>(_entries.size());
+  const auto fresh = count - indices.size();
+  if (_entries.size() + fresh > free_list_end) {
+    throw std::length_error("GenerationalIndexAllocator is full.");
+  }
+  _entries.resize(_entries.size() + fresh);
+  for (std::size_t i = 0; i < fresh; i++) {
+    indices.emplace_back(first + static_cast<GenerationalIndexType>(i), 0);
+    log_change(indices.back().index());
+  }
+  return indices;
 }
 
 bool GenerationalIndexAllocator::deallocate(const GenerationalIndex& index) {
-  if (!_entries[index.index()].is_live) {
+  flush();
+  if (!is_live(index)) {
     return false;
   }
-
-  _free.push(index.index());
-  _entries[index.index()].is_live = false;
+  auto& entry = _entries[index.index()];
+  entry.version++;
+  log_change(index.index());
+  if (index.generation() >= _last_generation) {
+    // reusing the slot would hand out a generation that was already used
+    _retired++;
+    return true;
+  }
+  append_free(index.index());
+  _reserve_head.store(_free_head, std::memory_order_relaxed);
   return true;
 }
+
+std::size_t GenerationalIndexAllocator::deallocate(
+    std::span<const GenerationalIndex> indices) {
+  std::size_t freed = 0;
+  for (const auto& index : indices) {
+    if (deallocate(index))
+      freed++;
+  }
+  return freed;
+}
+
+void GenerationalIndexAllocator::assign(
+    std::span<const AllocatorEntry> entries) {
+  if (entries.size() > free_list_end) {
+    throw std::length_error("GenerationalIndexAllocator is full.");
+  }
+  flush();
+  _entries.assign(entries.begin(), entries.end());
+  _free_head = _free_tail = free_list_end;
+  _free_count = 0;
+  _retired = 0;
+  for (std::size_t i = 0; i < _entries.size(); i++) {
+    auto& entry = _entries[i];
+    log_change(static_cast<GenerationalIndexType>(i));
+    if (entry.version % 2 == 1)
+      continue;
+    if (entry.version / 2 > _last_generation) {
+      _retired++;
+      continue;
+    }
+    append_free(static_cast<GenerationalIndexType>(i));
+  }
+  _reserve_head.store(_free_head, std::memory_order_relaxed);
+}
+
+void GenerationalIndexAllocator::patch(std::size_t allocated,
+                                       std::span<const SlotVersion> versions) {
+  if (allocated > free_list_end) {
+    throw std::length_error("GenerationalIndexAllocator is full.");
+  }
+  flush();
+  std::vector<GenerationalIndexType> changed;
+  changed.reserve(versions.size());
+  for (const auto& slot : versions) {
+    if (slot.index >= allocated) {
+      throw std::out_of_range("Patched slot is out of range.");
+    }
+    changed.push_back(slot.index);
+  }
+  std::sort(changed.begin(), changed.end());
+  // slots taken since, and maybe freed again, form the head of the list
+  while (_free_count > 0 &&
+         std::binary_search(changed.begin(), changed.end(), _free_head)) {
+    _free_head = _entries[_free_head].next_free;
+    _free_count--;
+  }
+  if (allocated > _entries.size()) {
+    _entries.resize(allocated);
+  }
+  for (const auto& slot : versions) {
+    auto& entry = _entries[slot.index];
+    entry.version = slot.version;
+    log_change(slot.index);
+    if (entry.version % 2 == 1)
+      continue;
+    if (entry.version / 2 > _last_generation) {
+      _retired++;
+      continue;
+    }
+    append_free(slot.index);
+  }
+  _reserve_head.store(_free_head, std::memory_order_relaxed);
+}
+
+std::vector<GenerationalIndexType> GenerationalIndexAllocator::free_list()
+    const {
+  std::vector<GenerationalIndexType> slots;
+  slots.reserve(_free_count);
+  auto index = _free_head;
+  for (std::size_t i = 0; i < _free_count; i++) {
+    slots.push_back(index);
+    index = _entries[index].next_free;
+  }
+  return slots;
+}
+
+GenerationalIndex GenerationalIndexAllocator::reserve() {
+  auto head = _reserve_head.load(std::memory_order_acquire);
+  while (head != free_list_end) {
+    // entries are only written outside of reservation, reading them is safe
+    const auto next = _entries[head].next_free;
+    if (_reserve_head.compare_exchange_weak(head, next,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+      return {head, (_entries[head].version + 1) / 2};
+    }
+  }
+  const auto offset = _fresh_reserved.fetch_add(1, std::memory_order_relaxed);
+  if (_entries.size() + offset >= free_list_end) {
+    throw std::length_error("GenerationalIndexAllocator is full.");
+  }
+  return {static_cast<GenerationalIndexType>(_entries.size() + offset), 0};
+}
+
+std::size_t GenerationalIndexAllocator::flush() {
+  std::size_t materialized = 0;
+  const auto head = _reserve_head.load(std::memory_order_acquire);
+  while (_free_head != head) {
+    auto& entry = _entries[_free_head];
+    entry.version++;
+    log_change(_free_head);
+    _free_count--;
+    _free_head = entry.next_free;
+    materialized++;
+  }
+  const auto fresh = std::min(
+      _fresh_reserved.exchange(0, std::memory_order_relaxed),
+      std::size_t{free_list_end} - _entries.size());
+  for (std::size_t i = 0; i < fresh; i++) {
+    log_change(static_cast<GenerationalIndexType>(_entries.size() + i));
+  }
+  _entries.resize(_entries.size() + fresh);
+  return materialized + fresh;
+}
+
+void GenerationalIndexAllocator::append_free(GenerationalIndexType index) {
+  _entries[index].next_free = free_list_end;
+  if (_free_count == 0) {
+    _free_head = index;
+  } else {
+    _entries[_free_tail].next_free = index;
+  }
+  _free_tail = index;
+  _free_count++;
+}
+
+GenerationalIndex GenerationalIndexAllocator::pop_free() {
+  const auto index = _free_head;
+  auto& entry = _entries[index];
+  _free_head = entry.next_free;
+  _reserve_head.store(_free_head, std::memory_order_relaxed);
+  _free_count--;
+  entry.version++;
+  log_change(index);
+  return {index, entry.version / 2};
+}
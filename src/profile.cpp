@@ -0,0 +1,217 @@
+#include <engine/profile.h>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define ENGINE_PROFILE_DEMANGLE 1
+#endif
+
+using namespace engine;
+
+namespace {
+constexpr std::array<const char*, profile_counter_count> counter_names{
+    "entities created", "entities destroyed", "components added",
+    "components removed"};
+
+// Small id of the calling thread, in order of first use.
+std::uint32_t thread_id() {
+  static std::atomic<std::uint32_t> next{0};
+  thread_local const std::uint32_t id = next++;
+  return id;
+}
+
+void write_json_string(std::ostream& out, std::string_view text) {
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out << ' ';
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+// Microseconds, the unit of Chrome trace timestamps.
+void write_us(std::ostream& out, std::uint64_t ns) {
+  out << ns / 1000 << '.' << ns / 100 % 10 << ns / 10 % 10 << ns % 10;
+}
+
+double to_ms(std::uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+}  // namespace
+
+std::string engine::type_name(const std::type_info& type) {
+#ifdef ENGINE_PROFILE_DEMANGLE
+  int status = 0;
+  std::unique_ptr<char, decltype(&std::free)> demangled{
+      abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &std::free};
+  if (status == 0 && demangled) {
+    return demangled.get();
+  }
+#endif
+  return type.name();
+}
+
+Profiler::Profiler(std::size_t max_events)
+    : _start(Clock::now()), _max_events(max_events) {}
+
+std::uint64_t Profiler::since_start(Clock::time_point time) const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time - _start)
+      .count();
+}
+
+void Profiler::add_event(Event event) {
+  if (_events.size() >= _max_events) {
+    _dropped++;
+    return;
+  }
+  _events.push_back(std::move(event));
+}
+
+void Profiler::record_zone(std::string_view name, Clock::time_point start,
+                           Clock::time_point end) {
+  const std::uint64_t start_ns = since_start(start);
+  const std::uint64_t duration_ns = since_start(end) - start_ns;
+  const auto thread = thread_id();
+  std::lock_guard lock{_mutex};
+  auto found = _zones.find(name);
+  if (found == _zones.end()) {
+    found = _zones.emplace(std::string{name}, ZoneStats{}).first;
+  }
+  auto& stats = found->second;
+  stats.calls++;
+  stats.total_ns += duration_ns;
+  stats.max_ns = std::max(stats.max_ns, duration_ns);
+  add_event({'X', std::string{name}, start_ns, duration_ns, thread, {}});
+}
+
+void Profiler::record_query(std::string_view name, std::size_t entities) {
+  std::lock_guard lock{_mutex};
+  auto found = _queries.find(name);
+  if (found == _queries.end()) {
+    found = _queries.emplace(std::string{name}, QueryStats{}).first;
+  }
+  found->second.calls++;
+  found->second.entities += entities;
+  found->second.frame_entities += entities;
+}
+
+void Profiler::record_pools(std::vector<PoolStats> pools) {
+  std::lock_guard lock{_mutex};
+  _pools = std::move(pools);
+}
+
+void Profiler::end_frame() {
+  const std::uint64_t now = since_start(Clock::now());
+  const auto thread = thread_id();
+  std::lock_guard lock{_mutex};
+  Event changes{'C', "structural changes", now, 0, thread, {}};
+  for (std::size_t i = 0; i < profile_counter_count; i++) {
+    _last_frame[i] = _counters[i].exchange(0, std::memory_order_relaxed);
+    _totals[i] += _last_frame[i];
+    changes.counters.emplace_back(counter_names[i], _last_frame[i]);
+  }
+  add_event(std::move(changes));
+  if (!_queries.empty()) {
+    Event queries{'C', "query entities", now, 0, thread, {}};
+    for (auto& [name, stats] : _queries) {
+      queries.counters.emplace_back(name, stats.frame_entities);
+      stats.frame_entities = 0;
+    }
+    add_event(std::move(queries));
+  }
+  for (const auto& pool : _pools) {
+    add_event({'C',
+               "pool " + pool.name,
+               now,
+               0,
+               thread,
+               {{"size", pool.array.size},
+                {"dense bytes", pool.array.dense_bytes},
+                {"sparse bytes", pool.array.sparse_bytes}}});
+  }
+  _frames++;
+}
+
+void Profiler::clear() {
+  std::lock_guard lock{_mutex};
+  _events.clear();
+  _dropped = 0;
+  _frames = 0;
+  _zones.clear();
+  _queries.clear();
+  _pools.clear();
+  for (auto& counter : _counters) {
+    counter.store(0, std::memory_order_relaxed);
+  }
+  _last_frame.fill(0);
+  _totals.fill(0);
+}
+
+void Profiler::write_chrome_trace(std::ostream& out) const {
+  std::lock_guard lock{_mutex};
+  out << "{\"traceEvents\":[";
+  for (std::size_t i = 0; i < _events.size(); i++) {
+    const auto& event = _events[i];
+    out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+    write_json_string(out, event.name);
+    out << ",\"ph\":\"" << event.phase << "\",\"ts\":";
+    write_us(out, event.start_ns);
+    if (event.phase == 'X') {
+      out << ",\"dur\":";
+      write_us(out, event.duration_ns);
+    }
+    out << ",\"pid\":0,\"tid\":" << event.thread;
+    if (!event.counters.empty()) {
+      out << ",\"args\":{";
+      for (std::size_t c = 0; c < event.counters.size(); c++) {
+        if (c > 0)
+          out << ',';
+        write_json_string(out, event.counters[c].first);
+        out << ':' << event.counters[c].second;
+      }
+      out << '}';
+    }
+    out << '}';
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void Profiler::write_stats(std::ostream& out) const {
+  std::lock_guard lock{_mutex};
+  out << "frames: " << _frames << "\n";
+  if (_dropped > 0) {
+    out << "dropped trace events: " << _dropped << "\n";
+  }
+  out << "zones: calls, total ms, mean ms, max ms\n";
+  for (const auto& [name, stats] : _zones) {
+    out << "  " << name << ": " << stats.calls << ", "
+        << to_ms(stats.total_ns) << ", "
+        << to_ms(stats.total_ns / std::max<std::uint64_t>(stats.calls, 1))
+        << ", " << to_ms(stats.max_ns) << "\n";
+  }
+  out << "queries: calls, entities\n";
+  for (const auto& [name, stats] : _queries) {
+    out << "  " << name << ": " << stats.calls << ", " << stats.entities
+        << "\n";
+  }
+  out << "pools: size, dense bytes, sparse bytes\n";
+  for (const auto& pool : _pools) {
+    out << "  " << pool.name << ": " << pool.array.size << ", "
+        << pool.array.dense_bytes << ", " << pool.array.sparse_bytes << "\n";
+  }
+  out << "structural changes: last frame, total\n";
+  for (std::size_t i = 0; i < profile_counter_count; i++) {
+    out << "  " << counter_names[i] << ": " << _last_frame[i] << ", "
+        << _totals[i] << "\n";
+  }
+}
+
+Profiler& engine::profiler() {
+  static Profiler instance;
+  return instance;
+}
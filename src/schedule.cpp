@@ -0,0 +1,27 @@
+#include <engine/schedule.h>
+#include <algorithm>
+
+using namespace engine;
+
+namespace {
+bool intersects(const std::vector<std::type_index>& a,
+                const std::vector<std::type_index>& b) {
+  auto it_a = a.begin();
+  auto it_b = b.begin();
+  while (it_a != a.end() && it_b != b.end()) {
+    if (*it_a < *it_b) {
+      ++it_a;
+    } else if (*it_b < *it_a) {
+      ++it_b;
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+bool SystemAccess::conflicts(const SystemAccess& other) const {
+  return intersects(writes, other.writes) || intersects(writes, other.reads) ||
+         intersects(reads, other.writes);
+}
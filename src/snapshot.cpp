@@ -0,0 +1,173 @@
+#include <engine/snapshot.h>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <new>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ENGINE_SNAPSHOT_MMAP 1
+#endif
+
+using namespace engine;
+
+namespace {
+constexpr std::array<char, 8> snapshot_magic{'E', 'L', 'D', 'E',
+                                             'R', 'S', 'N', 'P'};
+
+std::size_t align_up(std::size_t value) {
+  return (value + snapshot_alignment - 1) / snapshot_alignment *
+         snapshot_alignment;
+}
+}  // namespace
+
+void SnapshotWriter::add_bytes(std::uint64_t key, SnapshotSectionKind kind,
+                               std::size_t element_size, std::size_t count,
+                               std::span<const std::byte> bytes) {
+  _sections.push_back({key, kind, static_cast<std::uint32_t>(element_size),
+                       count, 0, bytes.size()});
+  _bytes.push_back(bytes);
+}
+
+void SnapshotWriter::write(const std::string& path) const {
+  SnapshotHeader header{};
+  std::copy(snapshot_magic.begin(), snapshot_magic.end(), header.magic);
+  header.version = snapshot_version;
+  header.sections = static_cast<std::uint32_t>(_sections.size());
+  header.tick = _tick;
+
+  auto sections = _sections;
+  std::size_t offset = align_up(sizeof(SnapshotHeader) +
+                                sections.size() * sizeof(SnapshotSection));
+  for (auto& section : sections) {
+    section.offset = offset;
+    offset = align_up(offset + section.size);
+  }
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error("Could not open snapshot file for writing.");
+  }
+  const std::array<char, snapshot_alignment> padding{};
+  std::size_t written = 0;
+  auto write = [&](const void* data, std::size_t size) {
+    file.write(static_cast<const char*>(data),
+               static_cast<std::streamsize>(size));
+    written += size;
+  };
+  auto pad = [&](std::size_t to) {
+    write(padding.data(), to - written);
+  };
+  write(&header, sizeof(header));
+  write(sections.data(), sections.size() * sizeof(SnapshotSection));
+  for (std::size_t i = 0; i < sections.size(); i++) {
+    pad(sections[i].offset);
+    write(_bytes[i].data(), _bytes[i].size());
+  }
+  pad(offset);
+  if (!file) {
+    throw std::runtime_error("Could not write snapshot file.");
+  }
+}
+
+Snapshot::Snapshot(const std::string& path) {
+#ifdef ENGINE_SNAPSHOT_MMAP
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                          PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        _data = static_cast<const std::byte*>(data);
+        _size = static_cast<std::size_t>(info.st_size);
+        _mapped = true;
+      }
+    }
+    ::close(fd);
+  }
+#endif
+  if (!_mapped) {
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    if (!file) {
+      throw std::runtime_error("Could not open snapshot file.");
+    }
+    _size = static_cast<std::size_t>(file.tellg());
+    auto* buffer = static_cast<std::byte*>(::operator new(
+        std::max<std::size_t>(_size, 1), std::align_val_t{snapshot_alignment}));
+    _data = buffer;
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer),
+              static_cast<std::streamsize>(_size));
+    if (!file) {
+      close();
+      throw std::runtime_error("Could not read snapshot file.");
+    }
+  }
+  try {
+    validate();
+  } catch (...) {
+    close();
+    throw;
+  }
+}
+
+Snapshot::~Snapshot() {
+  close();
+}
+
+void Snapshot::close() {
+  if (_data == nullptr)
+    return;
+#ifdef ENGINE_SNAPSHOT_MMAP
+  if (_mapped) {
+    ::munmap(const_cast<std::byte*>(_data), _size);
+    _data = nullptr;
+    return;
+  }
+#endif
+  ::operator delete(const_cast<std::byte*>(_data),
+                    std::align_val_t{snapshot_alignment});
+  _data = nullptr;
+}
+
+const SnapshotSection* Snapshot::find(std::uint64_t key,
+                                      SnapshotSectionKind kind) const {
+  const auto* sections =
+      reinterpret_cast<const SnapshotSection*>(_data + sizeof(SnapshotHeader));
+  for (std::uint32_t i = 0; i < header().sections; i++) {
+    if (sections[i].key == key && sections[i].kind == kind)
+      return &sections[i];
+  }
+  return nullptr;
+}
+
+void Snapshot::validate() const {
+  if (_size < sizeof(SnapshotHeader) ||
+      !std::equal(snapshot_magic.begin(), snapshot_magic.end(),
+                  header().magic)) {
+    throw std::runtime_error("Not a snapshot file.");
+  }
+  if (header().version != snapshot_version) {
+    throw std::runtime_error("Unsupported snapshot version.");
+  }
+  const std::size_t table_end = sizeof(SnapshotHeader) +
+                                header().sections * sizeof(SnapshotSection);
+  if (table_end > _size) {
+    throw std::runtime_error("Snapshot section table is truncated.");
+  }
+  const auto* sections =
+      reinterpret_cast<const SnapshotSection*>(_data + sizeof(SnapshotHeader));
+  for (std::uint32_t i = 0; i < header().sections; i++) {
+    const auto& section = sections[i];
+    if (section.offset % snapshot_alignment != 0 || section.offset > _size ||
+        section.size > _size - section.offset ||
+        (section.kind != SnapshotSectionKind::serialized &&
+         section.count * section.element_size != section.size)) {
+      throw std::runtime_error("Snapshot section is out of bounds.");
+    }
+  }
+}
@@ -0,0 +1,122 @@
+#include <engine/thread_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+using namespace engine;
+
+namespace {
+// Pool and worker slot of the current thread, set on worker threads only.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  _workers.reserve(threads);
+  for (std::size_t i = 0; i < threads; i++) {
+    _workers.emplace_back([this, i] {
+      current_pool = this;
+      current_worker = i + 1;
+      worker_loop();
+    });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{_mutex};
+    _stopping = true;
+  }
+  _task_ready.notify_all();
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::worker_loop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock{_mutex};
+      _task_ready.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+      if (_tasks.empty()) {
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop();
+    }
+    task();
+  }
+}
+
+std::size_t ThreadPool::worker_index() const {
+  return current_pool == this ? current_worker : 0;
+}
+
+bool ThreadPool::run_pending_task() {
+  std::function<void()> task;
+  {
+    std::lock_guard lock{_mutex};
+    if (_tasks.empty()) {
+      return false;
+    }
+    task = std::move(_tasks.front());
+    _tasks.pop();
+  }
+  task();
+  return true;
+}
+
+void ThreadPool::parallel_for(std::size_t count,
+                              const std::function<void(std::size_t)>& task) {
+  if (count == 0) {
+    return;
+  }
+  std::atomic_size_t next{0};
+  auto run = [&] {
+    for (auto i = next++; i < count; i = next++) {
+      task(i);
+    }
+  };
+  const auto helpers = std::min(count, _workers.size() + 1) - 1;
+  std::vector<std::future<void>> pending;
+  pending.reserve(helpers);
+  for (std::size_t i = 0; i < helpers; i++) {
+    pending.push_back(submit(run));
+  }
+
+  std::exception_ptr error;
+  try {
+    run();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // always wait, the helpers reference this frame. Queued tasks are run
+  // meanwhile so nested calls cannot starve the workers.
+  for (auto& future : pending) {
+    while (future.wait_for(std::chrono::seconds(0)) !=
+           std::future_status::ready) {
+      if (!run_pending_task()) {
+        std::this_thread::yield();
+      }
+    }
+    try {
+      future.get();
+    } catch (...) {
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+ThreadPool& engine::default_thread_pool() {
+  static ThreadPool pool;
+  return pool;
+}
@@ -0,0 +1,93 @@
+#include <engine/archetype.h>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+
+struct NameComponent {
+  std::string name{"default"};
+};
+}  // namespace
+
+TEST_CASE("Archetype moves", "[Archetype]") {
+  BasicRegistry<ArchetypeRegistry> registry;
+  auto& components = registry.components;
+  REQUIRE(components.register_component<PositionComponent>());
+  REQUIRE_FALSE(components.register_component<PositionComponent>());
+  components.register_component<VelocityComponent>();
+  components.register_component<NameComponent>();
+  ECS ecs;
+
+  Entity e0 = ecs.create();
+  Entity e1 = ecs.create();
+  REQUIRE(components.add_component<NameComponent>(e0, "e0"));
+  REQUIRE(components.add_component<PositionComponent>(e0, 1, 2));
+  REQUIRE_FALSE(components.add_component<PositionComponent>(e0, 3, 4));
+  REQUIRE(components.add_component<NameComponent>(e1, "e1"));
+  REQUIRE(components.add_component<PositionComponent>(e1, 5, 6));
+  REQUIRE(components.add_component<VelocityComponent>(e1, 1, 1));
+  // {Name}, {Name, Position}, {Name, Position, Velocity}
+  REQUIRE(components.archetypes() == 3);
+
+  REQUIRE(components.get_component<NameComponent>(e0).name == "e0");
+  REQUIRE(components.get_component<PositionComponent>(e1).y == 6);
+  REQUIRE(components.has_component<PositionComponent>().size() == 2);
+  REQUIRE(components.has_component<PositionComponent, VelocityComponent>()
+              .size() == 1);
+
+  foreach
+    <PositionComponent, VelocityComponent>(
+        components, [](PositionComponent& p, const VelocityComponent& v) {
+          p.x += v.x;
+          p.y += v.y;
+        });
+  REQUIRE(components.get_component<PositionComponent>(e1).x == 6);
+
+  REQUIRE(components.remove_component<PositionComponent>(e1));
+  REQUIRE_FALSE(components.remove_component<PositionComponent>(e1));
+  REQUIRE(components.get_component<NameComponent>(e1).name == "e1");
+  REQUIRE(components.get_component<VelocityComponent>(e1).x == 1);
+  REQUIRE(components.remove_all(e0));
+  REQUIRE(components.has_component<NameComponent>().size() == 1);
+}
+
+TEST_CASE("Archetype chunks", "[Archetype]") {
+  ArchetypeRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  std::vector<Entity> entities;
+  constexpr int num_entities = 10000;
+  for (int i = 0; i < num_entities; i++) {
+    Entity e = ecs.create();
+    components.add_component<PositionComponent>(e, i, 0);
+    components.add_component<VelocityComponent>(e, 1, 1);
+    entities.push_back(e);
+  }
+  // remove every other entity's velocity, refilling rows from chunk ends
+  for (int i = 0; i < num_entities; i += 2) {
+    components.remove_component<VelocityComponent>(entities[i]);
+  }
+  for (int i = 0; i < num_entities; i++) {
+    REQUIRE(components.get_component<PositionComponent>(entities[i]).x == i);
+  }
+  int moving = 0;
+  foreach
+    <PositionComponent, VelocityComponent>(
+        components, [&](const PositionComponent& p, const VelocityComponent&) {
+          REQUIRE(p.x % 2 == 1);
+          moving++;
+        });
+  REQUIRE(moving == num_entities / 2);
+}
@@ -0,0 +1,161 @@
+#include <engine/command_buffer.h>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct ProjectileComponent {
+  int owner;
+};
+}  // namespace
+
+TEST_CASE("Deferred changes", "[CommandBuffer]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<ProjectileComponent>();
+  ECS ecs;
+  for (int i = 0; i < 10; i++) {
+    components.add_component<PositionComponent>(ecs.create(), i, 0);
+  }
+
+  CommandBuffer commands;
+  REQUIRE(commands.empty());
+  // spawn a projectile for every even entity and drop the odd ones, while
+  // iterating the pool being changed
+  components.each<PositionComponent>([&](const PositionComponent& p) {
+    if (p.x % 2 == 0) {
+      auto projectile = commands.create();
+      commands.add_component<PositionComponent>(projectile, p.x, 1);
+      commands.add_component<ProjectileComponent>(projectile, p.x);
+    }
+  });
+  for (const auto& id : components.has_component<PositionComponent>()) {
+    if (components.get_component<PositionComponent>(id).x % 2 == 1) {
+      commands.remove_component<PositionComponent>(id);
+      commands.destroy(id);
+    }
+  }
+  REQUIRE(components.has_component<PositionComponent>().size() == 10);
+
+  auto created = commands.flush(ecs, components);
+  REQUIRE(commands.empty());
+  REQUIRE(created.size() == 5);
+  REQUIRE(components.has_component<PositionComponent>().size() == 10);
+  REQUIRE(components.has_component<PositionComponent, ProjectileComponent>()
+              .size() == 5);
+  REQUIRE(components.get_component<ProjectileComponent>(created[2]).owner == 4);
+}
+
+TEST_CASE("Changes replay in recorded order", "[CommandBuffer]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  ECS ecs;
+  const Entity added = ecs.create();
+  const Entity replaced = ecs.create();
+  const Entity doomed = ecs.create();
+  components.add_component<PositionComponent>(replaced, 1, 1);
+
+  CommandBuffer commands;
+  commands.destroy(doomed);
+  REQUIRE_FALSE(commands.empty());
+  commands.add_component<PositionComponent>(added, 2, 2);
+  commands.remove_component<PositionComponent>(added);
+  commands.remove_component<PositionComponent>(replaced);
+  commands.add_component<PositionComponent>(replaced, 3, 3);
+  commands.flush(ecs, components);
+  REQUIRE(commands.empty());
+
+  REQUIRE_FALSE(components.has<PositionComponent>(added));
+  REQUIRE(components.get_component<PositionComponent>(replaced).x == 3);
+  REQUIRE_FALSE(ecs.is_live(doomed));
+}
+
+TEST_CASE("Runs of changes apply in bulk", "[CommandBuffer]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<ProjectileComponent>();
+  ECS ecs;
+  const auto entities = ecs.create_many(100);
+  for (const auto& id : entities) {
+    components.add_component<ProjectileComponent>(id, 0);
+  }
+  auto& group = components.group<PositionComponent, ProjectileComponent>();
+
+  CommandBuffer commands;
+  for (int i = 0; i < 100; i++) {
+    commands.add_component<PositionComponent>(entities[i], i, 0);
+  }
+  // the first add of a run wins, as with one add_component at a time
+  commands.add_component<PositionComponent>(entities[0], -1, 0);
+  for (int i = 0; i < 100; i += 2) {
+    commands.remove_component<PositionComponent>(entities[i]);
+  }
+  commands.add_component<PositionComponent>(entities[0], 7, 0);
+  commands.flush(ecs, components);
+
+  REQUIRE(components.pool<PositionComponent>().size() == 51);
+  REQUIRE(group.size() == 51);
+  REQUIRE(components.get_component<PositionComponent>(entities[0]).x == 7);
+  REQUIRE(components.get_component<PositionComponent>(entities[99]).x == 99);
+  REQUIRE_FALSE(components.has<PositionComponent>(entities[2]));
+}
+
+TEST_CASE("Per thread buffers", "[CommandBuffer]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<ProjectileComponent>();
+  ECS ecs;
+  for (int i = 0; i < 5000; i++) {
+    components.add_component<PositionComponent>(ecs.create(), i, 0);
+  }
+
+  ThreadPool pool{4};
+  CommandBuffers commands{pool};
+  REQUIRE(commands.size() == 5);
+  parallel_foreach<PositionComponent>(
+      components,
+      [&](const PositionComponent& p) {
+        auto projectile = commands.local().create();
+        commands.local().add_component<ProjectileComponent>(projectile, p.x);
+      },
+      64, pool);
+  auto created = commands.flush(ecs, components);
+  REQUIRE(created.size() == 5000);
+  REQUIRE(components.has_component<ProjectileComponent>().size() == 5000);
+}
+
+TEST_CASE("Reserved entities", "[CommandBuffer]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<ProjectileComponent>();
+  ECS ecs;
+  for (int i = 0; i < 1000; i++) {
+    components.add_component<PositionComponent>(ecs.create(), i, 0);
+  }
+
+  ThreadPool pool{4};
+  CommandBuffers commands{pool};
+  std::vector<Entity> spawned(1000);
+  parallel_foreach<PositionComponent>(
+      components,
+      [&](const PositionComponent& p) {
+        // a real handle, usable before the flush
+        auto projectile = ecs.reserve();
+        commands.local().add_component<ProjectileComponent>(projectile, p.x);
+        spawned[p.x] = projectile;
+      },
+      64, pool);
+  REQUIRE_FALSE(ecs.is_live(spawned[0]));
+  commands.flush(ecs, components);
+  for (int i = 0; i < 1000; i++) {
+    const auto& projectile = spawned[i];
+    REQUIRE(ecs.is_live(projectile));
+    REQUIRE(components.get_component<ProjectileComponent>(projectile).owner ==
+            i);
+  }
+}
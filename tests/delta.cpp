@@ -0,0 +1,268 @@
+#include <engine/delta.h>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <string>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct NameComponent {
+  std::string name;
+};
+
+// Whether mirror has exactly source's ComponentType components.
+template <class ComponentType, typename Equal>
+bool same_components(Registry& source, Registry& mirror, Equal equal) {
+  auto& expected = source.components.pool<ComponentType>();
+  auto& actual = mirror.components.pool<ComponentType>();
+  if (expected.size() != actual.size())
+    return false;
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    const auto& id = expected.indices()[i];
+    const auto* value = actual.find(id);
+    if (value == nullptr || !equal(expected.values()[i], *value) ||
+        actual.ticks()[actual.position(id)].changed !=
+            expected.ticks()[i].changed)
+      return false;
+  }
+  return true;
+}
+
+bool same_world(Registry& source, Registry& mirror) {
+  return same_components<PositionComponent>(
+             source, mirror,
+             [](const auto& a, const auto& b) {
+               return a.x == b.x && a.y == b.y;
+             }) &&
+         same_components<NameComponent>(
+             source, mirror,
+             [](const auto& a, const auto& b) { return a.name == b.name; });
+}
+}  // namespace
+
+template <>
+struct engine::snapshot_traits<NameComponent> {
+  static void save(SnapshotOutput& out, const NameComponent& value) {
+    out.write(value.name);
+  }
+
+  static NameComponent load(SnapshotInput& in) { return {in.read_string()}; }
+};
+
+TEST_CASE("Delta mirrors a registry", "[Delta]") {
+  Registry source;
+  source.components.register_component<PositionComponent>();
+  source.components.register_component<NameComponent>();
+  auto entities = source.create_many(1000);
+  for (int i = 0; i < 1000; i++) {
+    source.components.add_component<PositionComponent>(entities[i], i, i);
+    if (i % 100 == 0) {
+      source.components.add_component<NameComponent>(entities[i],
+                                                     std::to_string(i));
+    }
+  }
+
+  Registry mirror;
+  DeltaEncoder encoder{source};
+  const auto full = encoder.encode<PositionComponent, NameComponent>();
+  apply_delta<PositionComponent, NameComponent>(full, mirror);
+  REQUIRE(same_world(source, mirror));
+  REQUIRE(mirror.components.tick() == encoder.since());
+
+  // a few changes in the next tick
+  source.components.get_component<PositionComponent>(entities[3]).x = -3;
+  source.components.remove_component<NameComponent>(entities[100]);
+  source.destroy(entities[7]);
+  source.destroy(entities[200]);
+  auto created = source.create();
+  REQUIRE(created.index() == entities[7].index());
+  source.components.add_component<NameComponent>(created, "new");
+  const auto delta = encoder.encode<PositionComponent, NameComponent>();
+  REQUIRE(delta.size() * 20 < full.size());
+  apply_delta<PositionComponent, NameComponent>(delta, mirror);
+  REQUIRE(same_world(source, mirror));
+  REQUIRE_FALSE(mirror.entities.is_live(entities[200]));
+  REQUIRE_FALSE(mirror.entities.is_live(entities[7]));
+  REQUIRE(mirror.entities.is_live(created));
+  REQUIRE(mirror.components.has<NameComponent>(created));
+  REQUIRE_FALSE(mirror.components.has<PositionComponent>(created));
+
+  // nothing changed, and deltas can't be applied twice
+  const auto empty = encoder.encode<PositionComponent, NameComponent>();
+  REQUIRE(empty.size() < 128);
+  apply_delta<PositionComponent, NameComponent>(empty, mirror);
+  REQUIRE(same_world(source, mirror));
+  REQUIRE_THROWS_AS((apply_delta<PositionComponent, NameComponent>(empty,
+                                                                   mirror)),
+                    std::runtime_error);
+  REQUIRE_THROWS_AS((apply_delta<PositionComponent>(delta, mirror)),
+                    std::runtime_error);
+}
+
+TEST_CASE("Removal logs", "[Delta]") {
+  GenerationalIndexArray<int> array;
+  array.set_tick(1);
+  array.emplace({0, 0}, 0);
+  array.emplace({1, 0}, 1);
+  array.remove({0, 0});
+  REQUIRE(array.removals().empty());
+
+  array.log_changes(true);
+  array.remove({1, 0});
+  array.set_tick(2);
+  for (unsigned i = 2; i < 40; i++) {
+    array.emplace({i, 0}, static_cast<int>(i));
+  }
+  std::vector<GenerationalIndex> all;
+  for (unsigned i = 2; i < 40; i++) {
+    all.push_back({i, 0});
+  }
+  array.remove_bulk(all);
+  REQUIRE(array.removals().size() == 39);
+  REQUIRE(array.removals().front().tick == 1);
+  array.trim_changes(1);
+  REQUIRE(array.removals().size() == 38);
+  REQUIRE(array.removals().front().tick == 2);
+}
+
+TEST_CASE("Change logs", "[Delta]") {
+  GenerationalIndexArray<int> array;
+  array.set_tick(1);
+  array.emplace({0, 0}, 0);
+  REQUIRE(array.changes().empty());
+
+  array.log_changes(true);
+  array.set_tick(2);
+  array.emplace({1, 0}, 1);
+  array.get({0, 0}) = 2;
+  array.touch_at(array.position({0, 0}));
+  REQUIRE(array.changes().size() == 2);
+  array.set_tick(3);
+  array.get({0, 0}) = 3;
+  REQUIRE(array.changes().size() == 3);
+  REQUIRE(array.changes().back().tick == 3);
+  array.trim_changes(2);
+  REQUIRE(array.changes().size() == 1);
+
+  GenerationalIndexAllocator allocator;
+  allocator.log_changes(true);
+  const auto first = allocator.allocate();
+  allocator.deallocate(first);
+  allocator.allocate(2);
+  REQUIRE(allocator.changes().size() == 4);
+  allocator.clear_changes();
+  REQUIRE(allocator.changes().empty());
+}
+
+TEST_CASE("Deltas only hold logged changes", "[Delta]") {
+  Registry source;
+  source.components.register_component<PositionComponent>();
+  source.components.register_component<NameComponent>();
+  auto entities = source.create_many(100);
+  for (int i = 0; i < 100; i++) {
+    source.components.add_component<PositionComponent>(entities[i], i, i);
+  }
+  Registry mirror;
+  DeltaEncoder encoder{source};
+  apply_delta<PositionComponent, NameComponent>(
+      encoder.encode<PositionComponent, NameComponent>(), mirror);
+  REQUIRE(source.entities.allocator().changes().empty());
+  REQUIRE(source.components.pool<PositionComponent>().changes().empty());
+
+  // changed over several ticks, changed then removed, added then destroyed
+  auto& positions = source.components.pool<PositionComponent>();
+  positions.get(entities[1]).x = -1;
+  source.components.advance_tick();
+  positions.get(entities[1]).y = -1;
+  positions.get(entities[2]).x = -2;
+  source.components.remove_component<PositionComponent>(entities[2]);
+  const Entity temporary = source.create();
+  source.components.add_component<NameComponent>(temporary, "temporary");
+  source.destroy(temporary);
+  REQUIRE(positions.changes().size() == 3);
+
+  apply_delta<PositionComponent, NameComponent>(
+      encoder.encode<PositionComponent, NameComponent>(), mirror);
+  REQUIRE(same_world(source, mirror));
+  REQUIRE(mirror.components.get_component<PositionComponent>(entities[1]).y ==
+          -1);
+  REQUIRE_FALSE(mirror.components.has<PositionComponent>(entities[2]));
+  REQUIRE_FALSE(mirror.entities.is_live(temporary));
+  REQUIRE(positions.changes().empty());
+}
+
+TEST_CASE("Parallel writes are logged for deltas", "[Delta]") {
+  Registry source;
+  source.components.register_component<PositionComponent>();
+  source.components.register_component<NameComponent>();
+  auto entities = source.create_many(10000);
+  for (int i = 0; i < 10000; i++) {
+    source.components.add_component<PositionComponent>(entities[i], i, i);
+  }
+  Registry mirror;
+  DeltaEncoder encoder{source};
+  apply_delta<PositionComponent, NameComponent>(
+      encoder.encode<PositionComponent, NameComponent>(), mirror);
+
+  // chunks collect their changes, logged once they have joined
+  ThreadPool pool{4};
+  parallel_foreach<PositionComponent>(
+      source.components,
+      [](PositionComponent& position) {
+        if (position.x % 3 == 0)
+          position.y = -position.y;
+      },
+      64, pool);
+  REQUIRE(source.components.pool<PositionComponent>().changes().size() ==
+          10000);
+  apply_delta<PositionComponent, NameComponent>(
+      encoder.encode<PositionComponent, NameComponent>(), mirror);
+  REQUIRE(same_world(source, mirror));
+  REQUIRE(mirror.components.get_component<PositionComponent>(entities[3]).y ==
+          -3);
+}
+
+TEST_CASE("Deltas keep the mirror's free list", "[Delta]") {
+  Registry source;
+  source.components.register_component<PositionComponent>();
+  source.components.register_component<NameComponent>();
+  auto entities = source.create_many(100);
+  // freed out of index order before the first delta
+  source.destroy(entities[50]);
+  source.destroy(entities[10]);
+  Registry mirror;
+  DeltaEncoder encoder{source};
+  apply_delta<PositionComponent, NameComponent>(
+      encoder.encode<PositionComponent, NameComponent>(), mirror);
+  auto& mirrored = mirror.entities.allocator();
+  REQUIRE(mirrored.free_list() == source.entities.allocator().free_list());
+
+  // recycled from the head, freed again, freed anew and grown
+  const auto recycled = source.create();
+  REQUIRE(recycled.index() == 50);
+  source.destroy(recycled);
+  source.destroy(entities[70]);
+  source.destroy(entities[20]);
+  source.create_many(5);
+  source.destroy(entities[30]);
+  mirrored.log_changes(true);
+  apply_delta<PositionComponent, NameComponent>(
+      encoder.encode<PositionComponent, NameComponent>(), mirror);
+  REQUIRE(mirrored.free_list() == source.entities.allocator().free_list());
+  REQUIRE(mirrored.allocated() == source.entities.allocator().allocated());
+  REQUIRE(mirrored.free() == source.entities.allocator().free());
+  for (std::size_t i = 0; i < mirrored.allocated(); i++) {
+    REQUIRE(mirrored.entries()[i].version ==
+            source.entities.allocator().entries()[i].version);
+  }
+  // only the changed slots are touched on the mirror
+  REQUIRE(mirrored.changes().size() < 20);
+
+  // both hand out the same entities afterwards
+  REQUIRE(mirror.create_many(4) == source.create_many(4));
+}
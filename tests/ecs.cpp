@@ -1,6 +1,8 @@
 #include <engine/ecs.h>
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 using namespace engine;
 
@@ -45,12 +47,20 @@ TEST_CASE("Entity Create", "[ECS]") {
 TEST_CASE("Resource Create", "[ECS]") {
   Registry registry;
   REQUIRE(registry.resources.register_resource<CounterResource>(15));
-  /*
   REQUIRE(registry.resources.register_resource<TextResource>(
       std::vector<std::string>{"String1", "String2"}));
   REQUIRE_FALSE(registry.resources.register_resource<TextResource>(
       std::vector<std::string>{"String3"}));
-    */
+
+  REQUIRE(registry.resources.get<CounterResource>().counter == 15);
+  registry.resources.get<CounterResource>().counter++;
+  REQUIRE(registry.resources.find<CounterResource>()->counter == 16);
+  REQUIRE(registry.resources.get<TextResource>().text.size() == 2);
+  REQUIRE(registry.resources.contains<TextResource>());
+  REQUIRE_FALSE(registry.resources.contains<PositionComponent>());
+  REQUIRE(registry.resources.find<PositionComponent>() == nullptr);
+  REQUIRE_THROWS_AS(registry.resources.get<PositionComponent>(),
+                    std::runtime_error);
 }
 
 TEST_CASE("View", "[ECS]") {
@@ -61,7 +71,7 @@ TEST_CASE("View", "[ECS]") {
   ECS ecs;
   Entity e0 = ecs.create();
   Entity e1 = ecs.create();
-  Entity e2 = ecs.create();
+  ecs.create();
 
   REQUIRE(registry.components.add_component<PositionComponent>(e0));
   REQUIRE(registry.components.add_component<PositionComponent>(e1, 10, 3));
@@ -122,3 +132,318 @@ TEST_CASE("Iterate View", "[ECS]") {
       REQUIRE(p.y == num_updates);
     });
 }
+
+TEST_CASE("Foreach partial overlap", "[ECS]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  for (int i = 0; i < 100; i++) {
+    Entity e = ecs.create();
+    components.add_component<PositionComponent>(e, i, 0);
+    if (i % 10 == 0) {
+      components.add_component<VelocityComponent>(e, 1, 0);
+    }
+  }
+  int visited = 0;
+  int sum = 0;
+  foreach
+    <VelocityComponent, PositionComponent>(
+        components, [&](const VelocityComponent& v, PositionComponent& p) {
+          visited++;
+          sum += p.x * v.x;
+        });
+  REQUIRE(visited == 10);
+  REQUIRE(sum == 450);
+  REQUIRE(components.has_component<PositionComponent, VelocityComponent>()
+              .size() == 10);
+}
+
+TEST_CASE("Parallel Iterate View", "[ECS]") {
+  Registry registry;
+  registry.components.register_component<PositionComponent>();
+  registry.components.register_component<VelocityComponent>();
+  ECS ecs;
+  constexpr int num_entities = 10000;
+  for (int i = 0; i < num_entities; i++) {
+    Entity e = ecs.create();
+    registry.components.add_component<PositionComponent>(e, 0, 0);
+    registry.components.add_component<VelocityComponent>(e, 1, 1);
+  }
+
+  ThreadPool pool{4};
+  constexpr int num_updates = 100;
+  for (int i = 0; i < num_updates; i++) {
+    parallel_foreach<PositionComponent, VelocityComponent>(
+        registry.components, update_position, 100, pool);
+  }
+  int mismatched = 0;
+  foreach
+    <PositionComponent>(registry.components, [&](const PositionComponent& p) {
+      if (p.x != num_updates || p.y != num_updates)
+        mismatched++;
+    });
+  REQUIRE(mismatched == 0);
+}
+
+TEST_CASE("Bulk create and remove", "[ECS]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  auto& moving = components.query<PositionComponent, VelocityComponent>();
+  ECS ecs;
+  auto entities = ecs.create_many(1000);
+  REQUIRE(entities.size() == 1000);
+  REQUIRE(entities[999].index() == 999);
+
+  REQUIRE(components.add_component_bulk<PositionComponent>(
+              entities,
+              [](std::size_t i) {
+                return PositionComponent{static_cast<int>(i), 0};
+              }) == 1000);
+  std::vector<VelocityComponent> velocities(500, VelocityComponent{1, 1});
+  REQUIRE(components.add_component_bulk<VelocityComponent>(
+              std::span{entities}.first(500),
+              std::span<const VelocityComponent>{velocities}) == 500);
+  REQUIRE(moving.size() == 500);
+
+  std::vector<Entity> odd;
+  for (std::size_t i = 1; i < entities.size(); i += 2) {
+    odd.push_back(entities[i]);
+  }
+  REQUIRE(components.remove_bulk<PositionComponent>(odd) == 500);
+  REQUIRE(components.remove_bulk<PositionComponent>(odd) == 0);
+  REQUIRE(moving.size() == 250);
+  const auto& remaining = components.pool<PositionComponent>().indices();
+  REQUIRE(remaining.size() == 500);
+  for (std::size_t i = 0; i < remaining.size(); i++) {
+    // compaction keeps the remaining order
+    REQUIRE(remaining[i].index() == i * 2);
+    REQUIRE(components.get_component<PositionComponent>(remaining[i]).x ==
+            static_cast<int>(i * 2));
+  }
+
+  for (const auto& id : odd) {
+    ecs.destroy(id);
+  }
+  auto recycled = ecs.create_many(600);
+  REQUIRE(recycled.size() == 600);
+  REQUIRE(recycled[0].generation() == 1);
+  REQUIRE(recycled[599].index() == 1099);
+}
+
+TEST_CASE("Component masks", "[ECS]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  components.register_component<NameComponent>();
+  ECS ecs;
+  Entity e0 = ecs.create();
+  Entity e1 = ecs.create();
+
+  REQUIRE(components.signature(e0).none());
+  components.add_component<PositionComponent>(e0);
+  components.add_component<VelocityComponent>(e0);
+  components.add_component<PositionComponent>(e1);
+  components.add_component<NameComponent>(e1);
+
+  REQUIRE(components.has<PositionComponent, VelocityComponent>(e0));
+  REQUIRE_FALSE(components.has<PositionComponent, VelocityComponent>(e1));
+  const auto position = components.mask<PositionComponent>();
+  const auto name = components.mask<NameComponent>();
+  REQUIRE(components.matches(e0, position, name));
+  REQUIRE_FALSE(components.matches(e1, position, name));
+
+  components.remove_component<PositionComponent>(e0);
+  REQUIRE(components.signature(e0) ==
+          components.mask<VelocityComponent>());
+  components.remove_component<VelocityComponent>(e0);
+  REQUIRE(components.signature(e0).none());
+
+  int visited = 0;
+  components.each<PositionComponent, NameComponent>(
+      [&](PositionComponent&, NameComponent&) { visited++; });
+  REQUIRE(visited == 1);
+}
+
+TEST_CASE("Destroy removes components", "[ECS]") {
+  Registry registry;
+  registry.components.register_component<PositionComponent>();
+  registry.components.register_component<VelocityComponent>();
+  registry.components.register_component<NameComponent>();
+  auto& moving =
+      registry.components.query<PositionComponent, VelocityComponent>();
+  Entity e0 = registry.create();
+  Entity e1 = registry.create();
+  registry.components.add_component<PositionComponent>(e0, 1, 2);
+  registry.components.add_component<VelocityComponent>(e0, 3, 4);
+  registry.components.add_component<NameComponent>(e1, "e1");
+  REQUIRE(moving.size() == 1);
+
+  REQUIRE(registry.destroy(e0));
+  REQUIRE_FALSE(registry.destroy(e0));
+  REQUIRE(moving.empty());
+  REQUIRE(registry.components.has_component<PositionComponent>().empty());
+  REQUIRE(registry.components.has_component<VelocityComponent>().empty());
+  REQUIRE(registry.components.has_component<NameComponent>().size() == 1);
+
+  // the recycled index starts without components
+  Entity e2 = registry.create();
+  REQUIRE(e2.index() == e0.index());
+  REQUIRE(registry.components.signature(e2).none());
+  REQUIRE(registry.components.add_component<PositionComponent>(e2, 5, 6));
+  REQUIRE(registry.components.get_component<PositionComponent>(e2).x == 5);
+}
+
+TEST_CASE("Change detection", "[ECS]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  auto entities = ecs.create_many(10);
+  for (const auto& id : entities) {
+    components.add_component<PositionComponent>(id, 0, 0);
+    components.add_component<VelocityComponent>(id, 1, 1);
+  }
+  auto count = [&]<class... Spec>(Tick since) {
+    int visited = 0;
+    components.each<Spec...>([&](const auto&...) { visited++; }, since);
+    return visited;
+  };
+  REQUIRE(count.template operator()<Added<PositionComponent>>(0) == 10);
+
+  const Tick frame = components.advance_tick();
+  REQUIRE(count.template operator()<Changed<PositionComponent>>(frame - 1) ==
+          0);
+  // reading through const parameters doesn't count as a change
+  components.each<PositionComponent, VelocityComponent>(
+      [](const PositionComponent&, const VelocityComponent&) {});
+  REQUIRE(count.template operator()<Changed<PositionComponent>>(frame - 1) ==
+          0);
+
+  // taking a non-const reference marks the component, written or not
+  int moved = 0;
+  components.each<PositionComponent, VelocityComponent>(
+      [&](PositionComponent& p, const VelocityComponent& v) {
+        if (moved++ < 3) {
+          p.x += v.x;
+        }
+      });
+  REQUIRE(count.template operator()<Changed<PositionComponent>>(frame - 1) ==
+          10);
+  REQUIRE(count.template operator()<Changed<VelocityComponent>>(frame - 1) ==
+          0);
+
+  components.advance_tick();
+  components.get_component<VelocityComponent>(entities[4]).x = 2;
+  components.add_component<PositionComponent>(ecs.create(), 0, 0);
+  int changed = 0;
+  components.each<PositionComponent, Changed<VelocityComponent>>(
+      [&](const PositionComponent&, const VelocityComponent& v) {
+        REQUIRE(v.x == 2);
+        changed++;
+      });
+  REQUIRE(changed == 1);
+  int added = 0;
+  components.each<Added<PositionComponent>>(
+      [&](const PositionComponent&) { added++; });
+  REQUIRE(added == 1);
+}
+
+TEST_CASE("Presence filters", "[ECS]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  components.register_component<NameComponent>();
+  ECS ecs;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 6; i++) {
+    entities.push_back(ecs.create());
+    components.add_component<PositionComponent>(entities.back(), i, 0);
+    if (i % 2 == 0)
+      components.add_component<VelocityComponent>(entities.back(), 1, 1);
+    if (i % 3 == 0)
+      components.add_component<NameComponent>(entities.back(), "named");
+  }
+
+  std::vector<int> xs;
+  components.each<PositionComponent, Without<VelocityComponent>>(
+      [&](const PositionComponent& p) { xs.push_back(p.x); });
+  std::sort(xs.begin(), xs.end());
+  REQUIRE(xs == std::vector<int>{1, 3, 5});
+
+  xs.clear();
+  components.each<With<NameComponent>, PositionComponent>(
+      [&](const PositionComponent& p) { xs.push_back(p.x); });
+  std::sort(xs.begin(), xs.end());
+  REQUIRE(xs == std::vector<int>{0, 3});
+
+  int named = 0;
+  int unnamed = 0;
+  components.each<PositionComponent, Optional<NameComponent>,
+                  Without<VelocityComponent>>(
+      [&](const PositionComponent& p, const NameComponent* name) {
+        if (name != nullptr) {
+          REQUIRE(p.x == 3);
+          REQUIRE(name->name == "named");
+          named++;
+        } else {
+          unnamed++;
+        }
+      });
+  REQUIRE(named == 1);
+  REQUIRE(unnamed == 2);
+
+  REQUIRE(components.has_component<VelocityComponent,
+                                   Without<NameComponent>>() ==
+          std::vector<Entity>{entities[2], entities[4]});
+  REQUIRE(components.has<PositionComponent, Without<VelocityComponent>>(
+      entities[1]));
+  REQUIRE_FALSE(components.has<PositionComponent, Without<VelocityComponent>>(
+      entities[0]));
+  REQUIRE(components.has<With<NameComponent>, Optional<VelocityComponent>>(
+      entities[3]));
+
+  // optional components taken through a non-const pointer count as changed
+  const Tick frame = components.advance_tick();
+  components.each<PositionComponent, Optional<VelocityComponent>>(
+      [](PositionComponent&, VelocityComponent* v) {
+        if (v != nullptr)
+          v->x++;
+      });
+  int changed = 0;
+  components.each<Changed<VelocityComponent>>(
+      [&](const VelocityComponent& v) {
+        REQUIRE(v.x == 2);
+        changed++;
+      },
+      frame - 1);
+  REQUIRE(changed == 3);
+}
+
+TEST_CASE("has_component with tick filters", "[ECS]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  const Entity old = ecs.create();
+  components.add_component<PositionComponent>(old, 0, 0);
+  components.add_component<VelocityComponent>(old, 0, 0);
+  components.advance_tick();
+  const Entity fresh = ecs.create();
+  components.add_component<PositionComponent>(fresh, 1, 1);
+  components.add_component<VelocityComponent>(fresh, 1, 1);
+
+  REQUIRE(components.has_component<Added<PositionComponent>,
+                                   VelocityComponent>() ==
+          std::vector<Entity>{fresh});
+  REQUIRE(components
+              .has_component<Added<PositionComponent>, VelocityComponent>(
+                  &components.frame_arena())
+              .size() == 1);
+  components.get<VelocityComponent>(old).x = 2;
+  const auto changed =
+      components.has_component<PositionComponent, Changed<VelocityComponent>>();
+  REQUIRE(changed.size() == 2);
+  REQUIRE(std::find(changed.begin(), changed.end(), old) != changed.end());
+}
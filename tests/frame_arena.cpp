@@ -0,0 +1,104 @@
+#include <engine/ecs.h>
+#include <engine/frame_arena.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <memory_resource>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+
+// Counts the allocations passed on to the default resource.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  std::size_t allocations = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    allocations++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+}  // namespace
+
+TEST_CASE("Frame arena", "[FrameArena]") {
+  CountingResource upstream;
+  FrameArena arena{256, &upstream};
+  REQUIRE(upstream.allocations == 1);
+  REQUIRE(arena.capacity() == 256);
+
+  auto* first = arena.allocate(10, 1);
+  auto* aligned = arena.allocate(8, 64);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+  REQUIRE(arena.used() > 10);
+  arena.reset();
+  REQUIRE(arena.used() == 0);
+  REQUIRE(arena.allocate(10, 1) == first);
+
+  // outgrowing the block adds one, the next reset merges them
+  for (int i = 0; i < 10; i++) {
+    static_cast<void>(arena.allocate(100, 8));
+  }
+  REQUIRE(upstream.allocations > 1);
+  const std::size_t capacity = arena.capacity();
+  arena.reset();
+  REQUIRE(arena.capacity() == capacity);
+  const std::size_t allocations = upstream.allocations;
+  for (int frame = 0; frame < 5; frame++) {
+    for (int i = 0; i < 10; i++) {
+      static_cast<void>(arena.allocate(100, 8));
+    }
+    arena.reset();
+  }
+  REQUIRE(upstream.allocations == allocations);
+}
+
+TEST_CASE("Registry memory resources", "[FrameArena]") {
+  CountingResource resource;
+  ComponentRegistry components{&resource};
+  ECS ecs;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  for (const auto& id : ecs.create_many(100)) {
+    components.add_component<PositionComponent>(id, 0, 0);
+    if (id.index() % 2 == 0) {
+      components.add_component<VelocityComponent>(id, 1, 1);
+    }
+  }
+  REQUIRE(resource.allocations > 0);
+  REQUIRE(components.pool<PositionComponent>().resource() == &resource);
+
+  auto& arena = components.frame_arena();
+  const std::size_t allocations = resource.allocations;
+  {
+    auto moving =
+        components.has_component<PositionComponent, VelocityComponent>(&arena);
+    REQUIRE(moving.size() == 50);
+    auto positioned = components.has_component<PositionComponent>(&arena);
+    REQUIRE(positioned.size() == 100);
+    REQUIRE(arena.used() > 0);
+  }
+  REQUIRE(resource.allocations == allocations);
+  components.advance_tick();
+  REQUIRE(arena.used() > 0);
+  components.reset_frame();
+  REQUIRE(arena.used() == 0);
+}
@@ -1,5 +1,7 @@
 #include <engine/generational_index.h>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -78,3 +80,171 @@ TEST_CASE("Array insert and remove", "[GenerationalIndexArray]") {
     REQUIRE(ints.get(index) == values[index.index()]);
   }
 }
+
+TEST_CASE("Array pages and large indices", "[GenerationalIndexArray]") {
+  GenerationalIndexArray<int> ints;
+  GenerationalIndex low{3, 0};
+  GenerationalIndex high{5000000, 0};
+  REQUIRE(ints.emplace(low, 3));
+  REQUIRE(ints.emplace(high, 5));
+  REQUIRE_FALSE(ints.emplace(high, 6));
+  REQUIRE(ints.size() == 2);
+  REQUIRE(ints.get(high) == 5);
+  REQUIRE_FALSE(ints.contains({5000001, 0}));
+
+  // removing the first packed item moves the last one into its slot
+  ints.remove(low);
+  REQUIRE_FALSE(ints.contains(low));
+  REQUIRE(ints.get(high) == 5);
+  ints.remove(high);
+  REQUIRE(ints.empty());
+}
+
+TEST_CASE("Packed arrays are cache line aligned", "[GenerationalIndexArray]") {
+  struct Odd {
+    char bytes[12];
+  };
+  GenerationalIndexArray<Odd> array;
+  for (unsigned i = 0; i < 100; i++) {
+    array.emplace({i, 0});
+    REQUIRE(reinterpret_cast<std::uintptr_t>(array.values().data()) %
+                cache_line_size ==
+            0);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(array.ticks().data()) %
+                cache_line_size ==
+            0);
+  }
+}
+
+TEST_CASE("Sparse array pages", "[PagedSparseArray]") {
+  PagedSparseArray sparse;
+  REQUIRE(sparse.pages() == 0);
+  REQUIRE_FALSE(sparse.contains(10));
+  sparse.set(10, 1);
+  sparse.set(11, 2);
+  REQUIRE(sparse.pages() == 1);
+  sparse.set(PagedSparseArray::page_size * 100, 3);
+  REQUIRE(sparse.pages() == 2);
+  REQUIRE(sparse.get(11) == 2);
+  REQUIRE(sparse.get_unchecked(PagedSparseArray::page_size * 100) == 3);
+  sparse.reset(10);
+  REQUIRE_FALSE(sparse.contains(10));
+  REQUIRE(sparse.get(PagedSparseArray::page_size * 50) ==
+          PagedSparseArray::tombstone);
+}
+
+TEST_CASE("Packed handle", "[GenerationalIndex]") {
+  constexpr GenerationalIndex a{7, 3};
+  static_assert(a.index() == 7 && a.generation() == 3);
+  static_assert(GenerationalIndex::from_value(a.value()) == a);
+  REQUIRE(GenerationalIndex{7, 3} == a);
+  REQUIRE(GenerationalIndex{7, 4} != a);
+  REQUIRE(GenerationalIndex{0, 0} != GenerationalIndex{1, 0});
+  REQUIRE(GenerationalIndex{6, 9} < a);
+  REQUIRE(a < GenerationalIndex{7, 4});
+
+  std::unordered_set<GenerationalIndex> handles{a, {7, 4}, {7, 3}};
+  REQUIRE(handles.size() == 2);
+
+  using SmallIndex = BasicGenerationalIndex<20, 12>;
+  constexpr SmallIndex small{SmallIndex::max_index, SmallIndex::max_generation};
+  static_assert(small.index() == (1u << 20) - 1);
+  static_assert(small.generation() == (1u << 12) - 1);
+  // generations wrap around
+  static_assert(
+      SmallIndex{1, SmallIndex::max_generation + 1}.generation() == 0);
+}
+
+TEST_CASE("Free list recycling", "[GenerationalIndexAllocator]") {
+  GenerationalIndexAllocator alloc;
+  auto indices = alloc.allocate(8);
+  REQUIRE(alloc.deallocate(std::span{indices}.subspan(2, 4)) == 4);
+  REQUIRE_FALSE(alloc.deallocate(indices[2]));
+  REQUIRE_FALSE(alloc.is_live(indices[2]));
+  REQUIRE(alloc.free() == 4);
+
+  // freed slots come back as a run, in the order they were freed
+  auto recycled = alloc.allocate(6);
+  for (std::size_t i = 0; i < 4; i++) {
+    REQUIRE(recycled[i].index() == i + 2);
+    REQUIRE(recycled[i].generation() == 1);
+    REQUIRE(alloc.is_live(recycled[i]));
+  }
+  REQUIRE(recycled[4].index() == 8);
+  REQUIRE(alloc.free() == 0);
+  // stale handles neither test live nor free the recycled slot
+  REQUIRE_FALSE(alloc.is_live(indices[3]));
+  REQUIRE_FALSE(alloc.deallocate(indices[3]));
+  REQUIRE(alloc.is_live(recycled[1]));
+}
+
+TEST_CASE("Generation wraparound", "[GenerationalIndexAllocator]") {
+  GenerationalIndexAllocator alloc{2};
+  auto index = alloc.allocate();
+  for (std::uint32_t generation = 0; generation < 2; generation++) {
+    REQUIRE(alloc.deallocate(index));
+    index = alloc.allocate();
+    REQUIRE(index.index() == 0);
+    REQUIRE(index.generation() == generation + 1);
+  }
+  // the slot reached its last generation and is retired
+  REQUIRE(alloc.deallocate(index));
+  REQUIRE(alloc.retired() == 1);
+  REQUIRE(alloc.free() == 0);
+  REQUIRE(alloc.allocate().index() == 1);
+}
+
+TEST_CASE("Forged high generations", "[GenerationalIndexAllocator]") {
+  GenerationalIndexAllocator alloc;
+  const auto index = alloc.allocate();
+  REQUIRE(index.generation() == 0);
+  // generation * 2 + 1 wraps to the live version 1 in 32 bits
+  const GenerationalIndex forged{index.index(), 0x80000000u};
+  REQUIRE_FALSE(alloc.is_live(forged));
+  REQUIRE_FALSE(alloc.deallocate(forged));
+  REQUIRE(alloc.is_live(index));
+}
+
+TEST_CASE("Concurrent reservation", "[GenerationalIndexAllocator]") {
+  GenerationalIndexAllocator alloc;
+  auto indices = alloc.allocate(200);
+  alloc.deallocate(std::span{indices}.first(100));
+
+  constexpr int threads = 4;
+  constexpr int per_thread = 100;
+  std::vector<std::vector<GenerationalIndex>> reserved(threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      for (int i = 0; i < per_thread; i++) {
+        reserved[t].push_back(alloc.reserve());
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::unordered_set<GenerationalIndex> unique;
+  std::size_t recycled = 0;
+  for (const auto& handles : reserved) {
+    for (const auto& handle : handles) {
+      unique.insert(handle);
+      REQUIRE_FALSE(alloc.is_live(handle));
+      if (handle.index() < 100) {
+        REQUIRE(handle.generation() == 1);
+        recycled++;
+      }
+    }
+  }
+  REQUIRE(unique.size() == threads * per_thread);
+  REQUIRE(recycled == 100);
+
+  REQUIRE(alloc.flush() == threads * per_thread);
+  REQUIRE(alloc.allocated() == 500);
+  REQUIRE(alloc.free() == 0);
+  for (const auto& handle : unique) {
+    REQUIRE(alloc.is_live(handle));
+  }
+  REQUIRE(alloc.allocate().index() == 500);
+}
@@ -0,0 +1,159 @@
+#include <engine/ecs.h>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+
+struct HealthComponent {
+  int value;
+};
+
+// Every grouped entity sits at the same packed position in both pools.
+void require_co_sorted(ComponentRegistry& components,
+                       const Group<PositionComponent, VelocityComponent>& g) {
+  const auto& positions = components.pool<PositionComponent>().indices();
+  const auto& velocities = components.pool<VelocityComponent>().indices();
+  for (std::size_t i = 0; i < g.size(); i++) {
+    REQUIRE(positions[i] == velocities[i]);
+  }
+}
+}  // namespace
+
+TEST_CASE("Group keeps pools co-sorted", "[Group]") {
+  Registry registry;
+  auto& components = registry.components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  components.register_component<HealthComponent>();
+  auto entities = registry.create_many(100);
+  for (int i = 0; i < 100; i++) {
+    components.add_component<PositionComponent>(entities[i], i, 0);
+    if (i % 3 == 0)
+      components.add_component<VelocityComponent>(entities[i], 1, 0);
+  }
+
+  auto& moving = components.group<PositionComponent, VelocityComponent>();
+  REQUIRE(&moving ==
+          &components.group<PositionComponent, VelocityComponent>());
+  REQUIRE(moving.size() == 34);
+  require_co_sorted(components, moving);
+  REQUIRE_THROWS_AS((components.group<VelocityComponent, HealthComponent>()),
+                    std::runtime_error);
+
+  components.add_component<VelocityComponent>(entities[1], 1, 0);
+  components.remove_component<PositionComponent>(entities[0]);
+  components.remove_component<VelocityComponent>(entities[99]);
+  registry.destroy(entities[3]);
+  std::vector<Entity> batch{entities[4], entities[5], entities[6]};
+  components.add_component_bulk<VelocityComponent>(
+      batch, [](std::size_t) { return VelocityComponent{1, 0}; });
+  REQUIRE(moving.size() == 34);
+  require_co_sorted(components, moving);
+  REQUIRE(moving.contains(entities[1]));
+  REQUIRE_FALSE(moving.contains(entities[0]));
+
+  // each<> over exactly the group's types scans its prefix
+  int visited = 0;
+  components.each<PositionComponent, VelocityComponent>(
+      [&](PositionComponent& p, const VelocityComponent& v) {
+        p.x += v.x;
+        visited++;
+      });
+  REQUIRE(visited == 34);
+  REQUIRE(components.get_component<PositionComponent>(entities[1]).x == 2);
+  REQUIRE(components.get_component<PositionComponent>(entities[2]).x == 2);
+
+  int sum = 0;
+  moving.each([&](const PositionComponent& p, const VelocityComponent&) {
+    sum += p.x;
+  });
+  int expected = 0;
+  for (const auto& id : moving.entities()) {
+    expected += components.get_component<PositionComponent>(id).x;
+  }
+  REQUIRE(sum == expected);
+}
+
+TEST_CASE("Group follows bulk adds and removes", "[Group]") {
+  Registry registry;
+  auto& components = registry.components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  auto entities = registry.create_many(200);
+  for (int i = 0; i < 200; i++) {
+    components.add_component<VelocityComponent>(entities[i], 1, 0);
+    if (i < 100)
+      components.add_component<PositionComponent>(entities[i], i, 0);
+  }
+  std::vector<Entity> rest(entities.begin() + 100, entities.end());
+  components.remove_bulk<VelocityComponent>(
+      std::span<const Entity>{entities}.first(50));
+  auto& moving = components.group<PositionComponent, VelocityComponent>();
+  REQUIRE(moving.size() == 50);
+
+  // each bulk added entity is swapped into the prefix while being notified,
+  // over the ungrouped positions in front of it
+  REQUIRE(components.add_component_bulk<PositionComponent>(
+              rest, [&](std::size_t i) {
+                return PositionComponent{static_cast<int>(i) + 100, 0};
+              }) == 100);
+  REQUIRE(moving.size() == 150);
+  require_co_sorted(components, moving);
+  components.add_component_bulk<VelocityComponent>(
+      std::span<const Entity>{entities}.first(50),
+      [](std::size_t) { return VelocityComponent{1, 0}; });
+  REQUIRE(moving.size() == 200);
+  require_co_sorted(components, moving);
+
+  std::vector<Entity> odd;
+  for (std::size_t i = 1; i < entities.size(); i += 2) {
+    odd.push_back(entities[i]);
+  }
+  REQUIRE(components.remove_bulk<VelocityComponent>(odd) == 100);
+  REQUIRE(moving.size() == 100);
+  require_co_sorted(components, moving);
+  for (std::size_t i = 0; i < entities.size(); i++) {
+    REQUIRE(moving.contains(entities[i]) == (i % 2 == 0));
+  }
+  for (const auto& id : moving.entities()) {
+    REQUIRE(components.get_component<PositionComponent>(id).x % 2 == 0);
+  }
+}
+
+TEST_CASE("Group marks written components as changed", "[Group]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  for (int i = 0; i < 3; i++) {
+    const Entity id = ecs.create();
+    components.add_component<PositionComponent>(id, i, 0);
+    components.add_component<VelocityComponent>(id, 1, 0);
+  }
+  auto& moving = components.group<PositionComponent, VelocityComponent>();
+  const Tick frame = components.advance_tick();
+  auto changed = [&]<class T>() {
+    int count = 0;
+    components.each<Changed<T>>([&](const T&) { count++; }, frame - 1);
+    return count;
+  };
+
+  moving.each([](const PositionComponent&, const VelocityComponent&) {});
+  REQUIRE(changed.template operator()<PositionComponent>() == 0);
+  moving.each([](PositionComponent& p, const VelocityComponent& v) {
+    p.x += v.x;
+  });
+  REQUIRE(changed.template operator()<PositionComponent>() == 3);
+  REQUIRE(changed.template operator()<VelocityComponent>() == 0);
+}
@@ -0,0 +1,122 @@
+#include <engine/ecs.h>
+#include <engine/profile.h>
+#include <engine/schedule.h>
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+}  // namespace
+
+TEST_CASE("Profiler exports", "[Profile]") {
+  Profiler profiler;
+  const auto start = Profiler::Clock::now();
+  profiler.record_zone("physics \"step\"", start,
+                       start + std::chrono::microseconds{1500});
+  profiler.record_zone("physics \"step\"", start,
+                       start + std::chrono::microseconds{500});
+  profiler.record_query("Position, Velocity", 10);
+  profiler.count(ProfileCounter::entities_created, 3);
+  profiler.count(ProfileCounter::components_added, 5);
+  profiler.record_pools({{"Position", {10, 480, 16384}}});
+  profiler.end_frame();
+  profiler.count(ProfileCounter::entities_created, 1);
+  profiler.end_frame();
+  REQUIRE(profiler.frames() == 2);
+
+  std::ostringstream trace;
+  profiler.write_chrome_trace(trace);
+  const auto json = trace.str();
+  REQUIRE(json.starts_with("{\"traceEvents\":["));
+  REQUIRE(json.find("\"name\":\"physics \\\"step\\\"\",\"ph\":\"X\"") !=
+          std::string::npos);
+  REQUIRE(json.find("\"dur\":1500.000") != std::string::npos);
+  REQUIRE(json.find("\"entities created\":3") != std::string::npos);
+  REQUIRE(json.find("\"Position, Velocity\":10") != std::string::npos);
+  REQUIRE(json.find("\"dense bytes\":480") != std::string::npos);
+
+  std::ostringstream stats;
+  profiler.write_stats(stats);
+  const auto text = stats.str();
+  REQUIRE(text.find("frames: 2") != std::string::npos);
+  REQUIRE(text.find("physics \"step\": 2, 2, 1, 1.5") != std::string::npos);
+  REQUIRE(text.find("Position: 10, 480, 16384") != std::string::npos);
+  REQUIRE(text.find("entities created: 1, 4") != std::string::npos);
+
+  profiler.clear();
+  REQUIRE(profiler.frames() == 0);
+}
+
+TEST_CASE("Profiler drops events past its limit", "[Profile]") {
+  Profiler profiler{2};
+  for (int i = 0; i < 5; i++) {
+    ProfileZone zone{"zone", profiler};
+  }
+  REQUIRE(profiler.dropped() == 3);
+  std::ostringstream stats;
+  profiler.write_stats(stats);
+  REQUIRE(stats.str().find("zone: 5,") != std::string::npos);
+}
+
+TEST_CASE("Pool stats", "[Profile]") {
+  Registry registry;
+  registry.components.register_component<PositionComponent>();
+  registry.components.register_component<VelocityComponent>();
+  for (const auto& id : registry.create_many(100)) {
+    registry.components.add_component<PositionComponent>(id, 0, 0);
+  }
+  const auto stats = registry.components.pool_stats();
+  REQUIRE(stats.size() == 3);
+  REQUIRE(stats[0].name.find("PositionComponent") != std::string::npos);
+  REQUIRE(stats[0].array.size == 100);
+  REQUIRE(stats[0].array.dense_bytes >=
+          100 * (sizeof(Entity) + sizeof(PositionComponent) +
+                 sizeof(ComponentTicks)));
+  REQUIRE(stats[0].array.sparse_bytes >=
+          PagedSparseArray::page_size * sizeof(SparseArrayIndexType));
+  REQUIRE(stats[1].array.size == 0);
+  REQUIRE(stats[1].array.sparse_bytes == 0);
+  REQUIRE(stats[2].name == "ComponentMask");
+  REQUIRE(stats[2].array.size == 100);
+}
+
+TEST_CASE("Schedule instrumentation", "[Profile]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  for (int i = 0; i < 10; i++) {
+    const auto id = ecs.create();
+    components.add_component<PositionComponent>(id, 0, 0);
+    components.add_component<VelocityComponent>(id, 1, 1);
+  }
+  Schedule<ComponentRegistry> schedule;
+  const auto move = schedule.add_system(
+      [](PositionComponent& p, const VelocityComponent& v) { p.x += v.x; });
+  REQUIRE(schedule.name(move) == "system 0");
+  schedule.set_name(move, "move");
+  REQUIRE(schedule.name(move) == "move");
+
+  profiler().clear();
+  schedule.run(components);
+  std::ostringstream stats;
+  profiler().write_stats(stats);
+  if constexpr (ENGINE_PROFILING) {
+    REQUIRE(profiler().frames() == 1);
+    REQUIRE(stats.str().find("  move: 1,") != std::string::npos);
+    REQUIRE(stats.str().find("VelocityComponent: 1, 10") != std::string::npos);
+  } else {
+    REQUIRE(profiler().frames() == 0);
+  }
+}
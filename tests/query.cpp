@@ -0,0 +1,75 @@
+#include <engine/ecs.h>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+}  // namespace
+
+TEST_CASE("Query tracks structural changes", "[Query]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  Entity e0 = ecs.create();
+  Entity e1 = ecs.create();
+  Entity e2 = ecs.create();
+  components.add_component<PositionComponent>(e0, 1, 1);
+  components.add_component<VelocityComponent>(e0, 1, 1);
+  components.add_component<PositionComponent>(e1, 2, 2);
+
+  auto& moving = components.query<PositionComponent, VelocityComponent>();
+  REQUIRE(moving.size() == 1);
+  REQUIRE(&moving == &components.query<PositionComponent, VelocityComponent>());
+
+  components.add_component<VelocityComponent>(e1, 1, 1);
+  components.add_component<VelocityComponent>(e2, 1, 1);
+  REQUIRE(moving.size() == 2);
+
+  REQUIRE(components.remove_component<PositionComponent>(e0));
+  REQUIRE_FALSE(components.remove_component<PositionComponent>(e0));
+  REQUIRE(moving.size() == 1);
+  REQUIRE(moving.entities()[0].index() == e1.index());
+
+  moving.each([](PositionComponent& p, const VelocityComponent& v) {
+    p.x += v.x;
+    p.y += v.y;
+  });
+  REQUIRE(components.get_component<PositionComponent>(e1).x == 3);
+}
+
+TEST_CASE("Query marks written components as changed", "[Query]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  for (int i = 0; i < 3; i++) {
+    const Entity id = ecs.create();
+    components.add_component<PositionComponent>(id, i, i);
+    components.add_component<VelocityComponent>(id, 1, 1);
+  }
+  auto& moving = components.query<PositionComponent, VelocityComponent>();
+  const Tick frame = components.advance_tick();
+  auto changed = [&]<class T>() {
+    int count = 0;
+    components.each<Changed<T>>([&](const T&) { count++; }, frame - 1);
+    return count;
+  };
+
+  moving.each([](const PositionComponent&, const VelocityComponent&) {});
+  REQUIRE(changed.template operator()<PositionComponent>() == 0);
+  moving.each([](PositionComponent& p, const VelocityComponent& v) {
+    p.x += v.x;
+  });
+  REQUIRE(changed.template operator()<PositionComponent>() == 3);
+  REQUIRE(changed.template operator()<VelocityComponent>() == 0);
+}
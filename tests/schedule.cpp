@@ -0,0 +1,139 @@
+#include <engine/schedule.h>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+
+struct HealthComponent {
+  int value;
+};
+
+void move_system(PositionComponent& p, const VelocityComponent& v) {
+  p.x += v.x;
+  p.y += v.y;
+}
+
+void regen_system(HealthComponent& h) {
+  h.value++;
+}
+}  // namespace
+
+TEST_CASE("Schedule waves", "[Schedule]") {
+  ThreadPool pool{2};
+  Schedule schedule{pool};
+  auto move = schedule.add_system(move_system);
+  auto regen = schedule.add_system(regen_system);
+  int seen = 0;
+  auto check = schedule.add_system(
+      [&](const PositionComponent& p, const HealthComponent& h) {
+        REQUIRE(p.x == 1);
+        REQUIRE(h.value == 1);
+        seen++;
+      });
+  auto drag = schedule.add_system([](VelocityComponent& v) { v.x = 0; });
+
+  REQUIRE(schedule.access(move).writes.size() == 1);
+  REQUIRE(schedule.access(move).reads.size() == 1);
+  REQUIRE(schedule.access(check).writes.empty());
+
+  // move and regen share nothing, check needs both, drag only conflicts with
+  // move's read of VelocityComponent
+  auto waves = schedule.waves();
+  REQUIRE(waves.size() == 2);
+  REQUIRE(waves[0] == std::vector<std::size_t>{move, regen});
+  REQUIRE(waves[1] == std::vector<std::size_t>{check, drag});
+
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  components.register_component<HealthComponent>();
+  ECS ecs;
+  for (int i = 0; i < 10; i++) {
+    Entity e = ecs.create();
+    components.add_component<PositionComponent>(e, 0, 0);
+    components.add_component<VelocityComponent>(e, 1, 1);
+    components.add_component<HealthComponent>(e, 0);
+  }
+  schedule.run(components);
+  REQUIRE(seen == 10);
+
+  schedule.order(check, regen);
+  REQUIRE_THROWS_AS(schedule.waves(), std::runtime_error);
+}
+
+TEST_CASE("Changed filter", "[Schedule]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 4; i++) {
+    entities.push_back(ecs.create());
+    components.add_component<PositionComponent>(entities.back(), i, 0);
+  }
+  components.add_component<VelocityComponent>(entities[0], 1, 0);
+
+  ThreadPool pool{2};
+  Schedule schedule{pool};
+  schedule.add_system(move_system);
+  int seen = 0;
+  schedule.add_system<Changed<PositionComponent>>(
+      [&](const PositionComponent&) { seen++; });
+
+  // first run sees every added position, then only the moving one
+  schedule.run(components);
+  REQUIRE(seen == 4);
+  seen = 0;
+  schedule.run(components);
+  REQUIRE(seen == 1);
+  seen = 0;
+  components.get_component<PositionComponent>(entities[3]).y = 5;
+  schedule.run(components);
+  REQUIRE(seen == 2);
+}
+
+TEST_CASE("Schedule advances the tick once per run", "[Schedule]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  const Entity entity = ecs.create();
+  components.add_component<PositionComponent>(entity, 0, 0);
+  components.add_component<VelocityComponent>(entity, 1, 0);
+
+  ThreadPool pool{2};
+  Schedule schedule{pool};
+  schedule.add_system(move_system);
+  int seen = 0;
+  schedule.add_system<Changed<PositionComponent>>(
+      [&](const PositionComponent&) { seen++; });
+  schedule.add_system([](VelocityComponent& v) { v.y++; });
+  REQUIRE(schedule.waves().size() == 2);
+
+  // scratch memory lives until reset_frame, not just to the next wave
+  auto& arena = components.frame_arena();
+  static_cast<void>(arena.allocate(64, 8));
+  const Tick tick = components.tick();
+  schedule.run(components);
+  REQUIRE(components.tick() == tick + 1);
+  REQUIRE(arena.used() > 0);
+  components.reset_frame();
+  REQUIRE(arena.used() == 0);
+
+  // the move made earlier in the same run is seen once
+  seen = 0;
+  schedule.run(components);
+  REQUIRE(components.tick() == tick + 2);
+  REQUIRE(seen == 1);
+}
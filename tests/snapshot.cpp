@@ -0,0 +1,95 @@
+#include <engine/snapshot.h>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct NameComponent {
+  std::string name;
+};
+
+std::string snapshot_path(const char* name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+}  // namespace
+
+template <>
+struct engine::snapshot_traits<NameComponent> {
+  static void save(SnapshotOutput& out, const NameComponent& value) {
+    out.write(value.name);
+  }
+
+  static NameComponent load(SnapshotInput& in) { return {in.read_string()}; }
+};
+
+TEST_CASE("Snapshot round trip", "[Snapshot]") {
+  const auto path = snapshot_path("elder_snapshot_round_trip.bin");
+  Registry saved;
+  saved.components.register_component<PositionComponent>();
+  saved.components.register_component<NameComponent>();
+  auto entities = saved.create_many(100);
+  for (int i = 0; i < 100; i++) {
+    saved.components.add_component<PositionComponent>(entities[i], i, -i);
+    if (i % 10 == 0) {
+      saved.components.add_component<NameComponent>(entities[i],
+                                                    std::to_string(i));
+    }
+  }
+  saved.destroy(entities[5]);
+  saved.destroy(entities[50]);
+  saved.components.advance_tick();
+  save_snapshot<PositionComponent, NameComponent>(path, saved);
+
+  Registry loaded;
+  loaded.components.register_component<PositionComponent>();
+  auto& moving = loaded.components.query<PositionComponent>();
+  load_snapshot<PositionComponent, NameComponent>(path, loaded);
+  REQUIRE(loaded.components.tick() == saved.components.tick());
+  REQUIRE(moving.size() == 98);
+  REQUIRE(loaded.components.has_component<PositionComponent>() ==
+          saved.components.has_component<PositionComponent>());
+  for (int i : {0, 7, 99}) {
+    const auto& p =
+        loaded.components.get_component<PositionComponent>(entities[i]);
+    REQUIRE(p.x == i);
+    REQUIRE(p.y == -i);
+  }
+  REQUIRE(loaded.components.has_component<NameComponent>().size() == 9);
+  REQUIRE(loaded.components.get_component<NameComponent>(entities[90]).name ==
+          "90");
+  REQUIRE(loaded.components.has<PositionComponent, NameComponent>(
+      entities[20]));
+
+  // the allocator continues where the saved one stopped
+  REQUIRE_FALSE(loaded.entities.is_live(entities[5]));
+  REQUIRE(loaded.entities.is_live(entities[6]));
+  auto recycled = loaded.create();
+  REQUIRE(recycled.index() == 5);
+  REQUIRE(recycled.generation() == 1);
+  REQUIRE_THROWS_AS((load_snapshot<PositionComponent>(path, loaded)),
+                    std::runtime_error);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Snapshot rejects bad files", "[Snapshot]") {
+  const auto path = snapshot_path("elder_snapshot_bad.bin");
+  {
+    std::ofstream file{path, std::ios::binary};
+    file << "not a snapshot at all, just some text";
+  }
+  Registry registry;
+  REQUIRE_THROWS_AS((load_snapshot<PositionComponent>(path, registry)),
+                    std::runtime_error);
+  std::filesystem::remove(path);
+  REQUIRE_THROWS_AS((load_snapshot<PositionComponent>(path, registry)),
+                    std::runtime_error);
+}
@@ -0,0 +1,87 @@
+#include <engine/ecs.h>
+#include <catch2/catch_test_macros.hpp>
+#include <span>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  float x;
+  float y;
+};
+
+struct VelocityComponent {
+  float x;
+  float y;
+};
+}  // namespace
+
+template <>
+struct engine::soa_layout<PositionComponent> {
+  static constexpr auto fields =
+      std::make_tuple(&PositionComponent::x, &PositionComponent::y);
+};
+
+template <>
+struct engine::soa_layout<VelocityComponent> {
+  static constexpr auto fields =
+      std::make_tuple(&VelocityComponent::x, &VelocityComponent::y);
+};
+
+namespace {
+void integrate(std::span<float> px, std::span<float> py,
+               std::span<const float> vx, std::span<const float> vy) {
+  for (std::size_t i = 0; i < px.size(); i++) {
+    px[i] += vx[i];
+    py[i] += vy[i];
+  }
+}
+}  // namespace
+
+TEST_CASE("SoA array", "[SoAIndexArray]") {
+  SoAIndexArray<PositionComponent> positions;
+  GenerationalIndex e0{0, 0};
+  GenerationalIndex e1{1, 0};
+  REQUIRE(positions.emplace(e0, 1.0f, 2.0f));
+  REQUIRE(positions.emplace(e1, 3.0f, 4.0f));
+  REQUIRE_FALSE(positions.emplace(e1, 5.0f, 6.0f));
+  REQUIRE(positions.get(e1).y == 4.0f);
+  positions.set(e0, {7.0f, 8.0f});
+  REQUIRE(positions.field<0>()[0] == 7.0f);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(positions.field<1>().data()) %
+              soa_alignment ==
+          0);
+  positions.remove(e0);
+  REQUIRE_FALSE(positions.contains(e0));
+  REQUIRE(positions.get(e1).x == 3.0f);
+}
+
+TEST_CASE("Foreach SIMD", "[SoAIndexArray]") {
+  ComponentRegistry components;
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  ECS ecs;
+  std::vector<Entity> entities;
+  constexpr int num_entities = 1000;
+  for (int i = 0; i < num_entities; i++) {
+    Entity e = ecs.create();
+    components.add_component<PositionComponent>(e, 0.0f, 0.0f);
+    components.add_component<VelocityComponent>(e, 1.0f, 2.0f);
+    entities.push_back(e);
+  }
+  // same packed order, spans cover the pools directly
+  foreach_simd<PositionComponent, const VelocityComponent>(components,
+                                                           integrate);
+  REQUIRE(components.pool<PositionComponent>().get(entities[10]).y == 2.0f);
+
+  // diverging order goes through gathered batches
+  for (int i = 0; i < num_entities; i += 3) {
+    components.remove_component<VelocityComponent>(entities[i]);
+  }
+  foreach_simd<PositionComponent, const VelocityComponent>(components,
+                                                           integrate);
+  for (int i = 0; i < num_entities; i++) {
+    auto p = components.pool<PositionComponent>().get(entities[i]);
+    REQUIRE(p.x == (i % 3 == 0 ? 1.0f : 2.0f));
+  }
+}
@@ -0,0 +1,130 @@
+#include <engine/ecs.h>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct Enemy {};
+struct Dirty {};
+
+static_assert(tag_component<Enemy>);
+static_assert(!tag_component<PositionComponent>);
+static_assert(std::is_same_v<ComponentPool<Enemy>, TagIndexArray<Enemy>>);
+static_assert(std::is_same_v<ComponentPool<PositionComponent>,
+                             GenerationalIndexArray<PositionComponent>>);
+}  // namespace
+
+TEST_CASE("TagIndexArray sets a bit per index", "[Tag]") {
+  TagIndexArray<Enemy> tags;
+  const Entity a{3, 0};
+  const Entity b{70, 0};
+  REQUIRE(tags.emplace(a));
+  REQUIRE(tags.emplace(b));
+  REQUIRE_FALSE(tags.emplace(a));
+  REQUIRE(tags.size() == 2);
+  REQUIRE(tags.contains(a));
+  REQUIRE_FALSE(tags.contains(Entity{4, 0}));
+  REQUIRE(tags.words().size() == 2);
+  REQUIRE(tags.words()[0] == std::uint64_t{1} << 3);
+  REQUIRE(tags.words()[1] == std::uint64_t{1} << 6);
+
+  REQUIRE(tags.erase(a));
+  REQUIRE_FALSE(tags.erase(a));
+  REQUIRE_THROWS_AS(tags.get(a), std::out_of_range);
+  REQUIRE(tags.size() == 1);
+  REQUIRE(tags.stats().dense_bytes == tags.words().size() * 8);
+  REQUIRE(tags.stats().sparse_bytes == 0);
+}
+
+TEST_CASE("Tags are added, removed and queried", "[Tag]") {
+  Registry registry;
+  auto& components = registry.components;
+  components.register_component<PositionComponent>();
+  components.register_component<Enemy>();
+  components.register_component<Dirty>();
+  const auto entities = registry.create_many(8);
+  for (std::size_t i = 0; i < entities.size(); i++) {
+    components.add_component<PositionComponent>(entities[i],
+                                                static_cast<int>(i), 0);
+    if (i % 2 == 0)
+      components.add_component<Enemy>(entities[i]);
+    if (i % 4 == 0)
+      components.add_component<Dirty>(entities[i]);
+  }
+  REQUIRE_FALSE(components.add_component<Enemy>(entities[0]));
+  REQUIRE(components.has<Enemy>(entities[2]));
+  REQUIRE_FALSE(components.has<Enemy>(entities[1]));
+  REQUIRE(components.has_component<Enemy>().size() == 4);
+  REQUIRE(components.has_component<Enemy, Dirty>() ==
+          std::vector<Entity>{entities[0], entities[4]});
+
+  std::vector<int> xs;
+  components.each<PositionComponent, Enemy>(
+      [&](const PositionComponent& position, const Enemy&) {
+        xs.push_back(position.x);
+      });
+  std::sort(xs.begin(), xs.end());
+  REQUIRE(xs == std::vector<int>{0, 2, 4, 6});
+
+  xs.clear();
+  components.each<PositionComponent, Without<Enemy>>(
+      [&](const PositionComponent& position) { xs.push_back(position.x); });
+  std::sort(xs.begin(), xs.end());
+  REQUIRE(xs == std::vector<int>{1, 3, 5, 7});
+  std::size_t dirty_enemies = 0;
+  components.each<Enemy, Optional<Dirty>>([&](Enemy, const Dirty* dirty) {
+    dirty_enemies += dirty != nullptr;
+  });
+  REQUIRE(dirty_enemies == 2);
+
+  REQUIRE(components.remove_component<Enemy>(entities[2]));
+  REQUIRE_FALSE(components.remove_component<Enemy>(entities[2]));
+  REQUIRE(components.remove_bulk<Enemy>(entities) == 3);
+  REQUIRE(components.has_component<Enemy>().empty());
+  REQUIRE(components.pool<Enemy>().empty());
+}
+
+TEST_CASE("Destroyed entities lose their tags", "[Tag]") {
+  Registry registry;
+  auto& components = registry.components;
+  components.register_component<Enemy>();
+  const Entity first = registry.create();
+  REQUIRE(components.add_component<Enemy>(first));
+  REQUIRE(registry.destroy(first));
+  REQUIRE(components.pool<Enemy>().empty());
+
+  // the recycled index is free of the old generation's tag
+  const Entity second = registry.create();
+  REQUIRE(second.index() == first.index());
+  REQUIRE_FALSE(components.has<Enemy>(second));
+  REQUIRE_FALSE(components.remove_component<Enemy>(first));
+  REQUIRE(components.add_component<Enemy>(second));
+  REQUIRE(components.has_component<Enemy>() == std::vector<Entity>{second});
+}
+
+TEST_CASE("Bulk added tags only set bits", "[Tag]") {
+  Registry registry;
+  auto& components = registry.components;
+  components.register_component<Enemy>();
+  const auto entities = registry.create_many(100);
+  REQUIRE(components.add_component_bulk<Enemy>(
+              entities, [](std::size_t) { return Enemy{}; }) == 100);
+  std::size_t visited = 0;
+  components.each<Enemy>([&](Enemy&) { visited++; });
+  REQUIRE(visited == 100);
+
+  const auto stats = components.pool_stats();
+  const auto enemy = std::find_if(stats.begin(), stats.end(), [](auto& pool) {
+    return pool.name.find("Enemy") != std::string::npos;
+  });
+  REQUIRE(enemy != stats.end());
+  REQUIRE(enemy->array.size == 100);
+  REQUIRE(enemy->array.dense_bytes <= 2 * sizeof(std::uint64_t));
+}
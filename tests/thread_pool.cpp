@@ -0,0 +1,30 @@
+#include <engine/thread_pool.h>
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <stdexcept>
+
+using namespace engine;
+
+TEST_CASE("Parallel for", "[ThreadPool]") {
+  ThreadPool pool{4};
+  REQUIRE(pool.size() == 4);
+  std::vector<int> hits(1000, 0);
+  pool.parallel_for(hits.size(), [&](std::size_t i) { hits[i]++; });
+  REQUIRE(std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; }));
+
+  // nested calls run inline when every worker is busy
+  std::atomic_int nested{0};
+  pool.parallel_for(8, [&](std::size_t) {
+    pool.parallel_for(8, [&](std::size_t) { nested++; });
+  });
+  REQUIRE(nested == 64);
+
+  REQUIRE_THROWS_AS(pool.parallel_for(
+                        4,
+                        [](std::size_t i) {
+                          if (i == 2)
+                            throw std::runtime_error("task failed");
+                        }),
+                    std::runtime_error);
+  REQUIRE(pool.submit([] {}).valid());
+}
@@ -0,0 +1,53 @@
+#include <engine/type_map.h>
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <set>
+#include <string>
+
+using namespace engine;
+
+namespace {
+struct First {};
+struct Second {};
+struct Third {};
+}  // namespace
+
+TEST_CASE("Type map", "[TypeMap]") {
+  TypeMap<std::string> map;
+  REQUIRE(map.begin() == map.end());
+  REQUIRE(map.find<First>() == map.end());
+  REQUIRE(map.get<First>() == nullptr);
+
+  REQUIRE(map.emplace<Second>("second"));
+  REQUIRE_FALSE(map.emplace<Second>("again"));
+  map.put<Third>("third");
+  map.put<Third>("replaced");
+  REQUIRE_FALSE(map.contains<First>());
+  REQUIRE(map.contains<Second>());
+  REQUIRE(*map.get<Second>() == "second");
+  REQUIRE(map.find<Third>()->second == "replaced");
+  REQUIRE(map.find<Third>()->first == TypeMap<std::string>::type_id<Third>());
+
+  std::set<std::string> values;
+  for (const auto& [id, value] : map) {
+    values.insert(value);
+  }
+  REQUIRE(values == std::set<std::string>{"second", "replaced"});
+
+  // ids are dense per value type
+  REQUIRE(TypeMap<std::string>::type_id<First>() !=
+          TypeMap<std::string>::type_id<Second>());
+  REQUIRE(TypeMap<std::unique_ptr<int>>::type_id<Third>() < 3);
+
+  TypeMap<std::unique_ptr<int>> owning;
+  owning.put<First>(std::make_unique<int>(1));
+  REQUIRE(**owning.get<First>() == 1);
+}
+
+TEST_CASE("Stable type ids", "[TypeMap]") {
+  constexpr auto first = stable_type_id<First>();
+  static_assert(first == stable_type_id<First>());
+  static_assert(stable_type_id<First>() != stable_type_id<Second>());
+  static_assert(stable_type_id<int>() != stable_type_id<const int>());
+  REQUIRE(first != 0);
+}
@@ -0,0 +1,146 @@
+#include <engine/world.h>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <tuple>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+
+struct Enemy {};
+
+using MovingView = View<GenerationalIndexArray<PositionComponent>,
+                        const GenerationalIndexArray<VelocityComponent>>;
+static_assert(std::ranges::forward_range<MovingView>);
+static_assert(std::ranges::view<MovingView>);
+static_assert(std::is_same_v<std::ranges::range_reference_t<MovingView>,
+                             std::tuple<Entity, PositionComponent&,
+                                        const VelocityComponent&>>);
+
+// Entities 0..count with a position, every other one also moving.
+std::vector<Entity> populate(ComponentRegistry& components, ECS& ecs,
+                             int count) {
+  components.register_component<PositionComponent>();
+  components.register_component<VelocityComponent>();
+  std::vector<Entity> entities;
+  for (int i = 0; i < count; i++) {
+    entities.push_back(ecs.create());
+    components.add_component<PositionComponent>(entities.back(), i, 0);
+    if (i % 2 == 0)
+      components.add_component<VelocityComponent>(entities.back(), 1, 2);
+  }
+  return entities;
+}
+}  // namespace
+
+TEST_CASE("View yields entities with all components", "[View]") {
+  ComponentRegistry components;
+  ECS ecs;
+  const auto entities = populate(components, ecs, 10);
+
+  std::vector<int> xs;
+  for (auto [id, position, velocity] :
+       components.view<PositionComponent, const VelocityComponent>()) {
+    REQUIRE(position.x == static_cast<int>(id.index()));
+    position.x += velocity.x;
+    xs.push_back(position.x);
+  }
+  std::sort(xs.begin(), xs.end());
+  REQUIRE(xs == std::vector<int>{1, 3, 5, 7, 9});
+  REQUIRE(components.get<PositionComponent>(entities[4]).x == 5);
+  REQUIRE(components.get<PositionComponent>(entities[5]).x == 5);
+
+  auto moving = components.view<const PositionComponent, VelocityComponent>();
+  REQUIRE(std::ranges::distance(moving) == 5);
+  REQUIRE_FALSE(moving.empty());
+  REQUIRE(components.view<VelocityComponent>().begin() !=
+          components.view<VelocityComponent>().end());
+}
+
+TEST_CASE("View composes with range adaptors", "[View]") {
+  ComponentRegistry components;
+  ECS ecs;
+  populate(components, ecs, 100);
+
+  auto first = components.view<const PositionComponent,
+                               const VelocityComponent>() |
+               std::views::take(3);
+  REQUIRE(std::ranges::distance(first) == 3);
+
+  auto far = components.view<const PositionComponent>() |
+             std::views::filter([](const auto& entry) {
+               return std::get<1>(entry).x >= 95;
+             });
+  std::vector<Entity> ids;
+  for (const auto& [id, position] : far) {
+    ids.push_back(id);
+  }
+  REQUIRE(ids.size() == 5);
+
+  // stops at the first match
+  const auto moving =
+      components.view<const PositionComponent, const VelocityComponent>();
+  const auto found = std::ranges::find_if(moving, [](const auto& entry) {
+    return std::get<1>(entry).x > 10;
+  });
+  REQUIRE(std::get<1>(*found).x == 12);
+}
+
+TEST_CASE("View marks written components as changed", "[View]") {
+  ComponentRegistry components;
+  components.register_component<Enemy>();
+  ECS ecs;
+  const auto entities = populate(components, ecs, 10);
+  components.add_component<Enemy>(entities[3]);
+  const Tick frame = components.advance_tick();
+
+  for (auto [id, position] : components.view<const PositionComponent>()) {
+    REQUIRE(position.x >= 0);
+  }
+  for (auto [id, velocity, enemy] :
+       components.view<VelocityComponent, Enemy>()) {
+    velocity.x++;
+  }
+  for (auto [id, position, enemy] :
+       components.view<PositionComponent, const Enemy>()) {
+    REQUIRE(id == entities[3]);
+    position.x = 30;
+  }
+  int changed = 0;
+  components.each<Changed<PositionComponent>>(
+      [&](const PositionComponent& p) {
+        REQUIRE(p.x == 30);
+        changed++;
+      },
+      frame - 1);
+  REQUIRE(changed == 1);
+}
+
+TEST_CASE("World views", "[View]") {
+  World<PositionComponent, VelocityComponent> world;
+  ECS ecs;
+  for (int i = 0; i < 4; i++) {
+    const Entity id = ecs.create();
+    world.add_component<PositionComponent>(id, i, i);
+    if (i > 1)
+      world.add_component<VelocityComponent>(id, 1, 1);
+  }
+  int sum = 0;
+  for (auto [id, position, velocity] :
+       world.view<const PositionComponent, const VelocityComponent>()) {
+    sum += position.x + velocity.x;
+  }
+  REQUIRE(sum == 7);
+}
@@ -0,0 +1,53 @@
+#include <engine/world.h>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace engine;
+
+namespace {
+struct PositionComponent {
+  int x;
+  int y;
+};
+
+struct VelocityComponent {
+  int x;
+  int y;
+};
+
+struct NameComponent {
+  std::string name{"default"};
+};
+
+using TestWorld = World<PositionComponent, VelocityComponent, NameComponent>;
+}  // namespace
+
+TEST_CASE("World components", "[World]") {
+  TestWorld world;
+  ECS ecs;
+  Entity e0 = ecs.create();
+  Entity e1 = ecs.create();
+
+  REQUIRE_FALSE(world.register_component<PositionComponent>());
+  REQUIRE(world.add_component<PositionComponent>(e0, 1, 2));
+  REQUIRE_FALSE(world.add_component<PositionComponent>(e0, 3, 4));
+  REQUIRE(world.add_component<PositionComponent>(e1, 5, 6));
+  REQUIRE(world.add_component<VelocityComponent>(e1, 1, 1));
+  REQUIRE(world.add_component<NameComponent>(e1, "e1"));
+
+  REQUIRE(world.has_component<PositionComponent>().size() == 2);
+  REQUIRE(world.has_component<PositionComponent, VelocityComponent>().size() ==
+          1);
+  REQUIRE(world.get_component<NameComponent>(e1).name == "e1");
+
+  foreach
+    <PositionComponent, VelocityComponent>(
+        world, [](PositionComponent& p, const VelocityComponent& v) {
+          p.x += v.x;
+          p.y += v.y;
+        });
+  REQUIRE(world.get_component<PositionComponent>(e1).x == 6);
+  REQUIRE(world.get_component<PositionComponent>(e0).x == 1);
+
+  REQUIRE(world.remove_component<VelocityComponent>(e1));
+  REQUIRE(world.has_component<PositionComponent, VelocityComponent>().empty());
+}